@@ -1,204 +1,365 @@
 // AI.cpp
 #include "AI.h"
+#include "MovePicker.h"
 #include <algorithm>
-#include <limits>
 #include <cstdlib>
 #include <ctime>
 
-AI::AI(PIECE_COLOR aiColor) : aiColor(aiColor) {
+namespace {
+    bool IsMateScore(int score) {
+        return std::abs(score) >= AI::MATE_SCORE - AI::MAX_PLY;
+    }
+
+    // Mate scores count plies from the root, but the table is shared by every path to a
+    // position, so they are stored counting from the position itself.
+    int ScoreToTable(int score, int ply) {
+        return !IsMateScore(score) ? score : score > 0 ? score + ply : score - ply;
+    }
+
+    int ScoreFromTable(int score, int ply) {
+        return !IsMateScore(score) ? score : score > 0 ? score - ply : score + ply;
+    }
+}
+
+AI::AI(PIECE_COLOR aiColor, size_t hashMegabytes) : aiColor(aiColor), table(hashMegabytes) {
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
 }
 
-std::pair<Piece*, Move> AI::GetBestMove(Board& board) {
-    std::vector<Piece*> pieces = board.GetPiecesByColor(aiColor);
-    std::pair<Piece*, Move> bestMove = {nullptr, {}};
-    int bestScore = std::numeric_limits<int>::min();
-    bool foundValidMove = false;
-    
-    // Map to store all possible moves per piece
-    std::map<Piece*, std::vector<Move>> possibleMovesPerPiece;
-    
-    // Calculate all possible moves for all pieces
-    for (Piece* piece : pieces) {
-        std::vector<Move> moves = piece->GetPossibleMoves(board);
-        std::vector<Move> validMoves;
-        
-        // Filter moves that lead to check
-        for (const Move& move : moves) {
-            if (!board.MoveLeadsToCheck(piece, move)) {
-                validMoves.push_back(move);
-            }
+PackedMove AI::GetBestMove(Board& board, int maxDepth, int timeBudgetMs) {
+    auto start = std::chrono::steady_clock::now();
+
+    nodes = 0;
+    cutoffs = 0;
+    firstMoveCutoffs = 0;
+    completedDepth = 0;
+    completedScore = 0;
+    previousPvLength = 0;
+    hasDeadline = timeBudgetMs != NO_TIME_LIMIT;
+    deadline = start + std::chrono::milliseconds(timeBudgetMs);
+    stopped = false;
+    table.NewSearch();
+
+    // The AI only moves on its own turn
+    if (board.GetState().sideToMove != aiColor) {
+        return PackedMove::None();
+    }
+
+    for (SearchStackEntry& entry : stack) {
+        entry.pvLength = 0;
+        entry.killers[0] = entry.killers[1] = PackedMove::None();
+    }
+
+    history.Clear();
+
+    for (int depth = 1; depth <= std::min(maxDepth, MAX_PLY - 1); depth++) {
+        followingPv = true;
+        int iterationScore = Search(board, depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+
+        // An unfinished iteration may not have looked at the best move yet, so its result is dropped
+        if (stopped) {
+            break;
         }
-        
-        if (!validMoves.empty()) {
-            possibleMovesPerPiece[piece] = validMoves;
-            foundValidMove = true;
+
+        // Without legal moves (checkmate or stalemate) the root gets no line
+        if (stack[0].pvLength == 0) {
+            break;
+        }
+
+        completedDepth = depth;
+        completedScore = iterationScore;
+        previousPvLength = stack[0].pvLength;
+        std::copy(stack[0].pv, stack[0].pv + previousPvLength, previousPv);
+
+        // A forced mate will not get any shorter by searching deeper
+        if (IsMateScore(completedScore)) {
+            break;
+        }
+
+        // The next iteration takes several times as long as this one, so it is only started
+        // if it has a chance to finish
+        if (hasDeadline && std::chrono::steady_clock::now() - start > (deadline - start) / 2) {
+            break;
         }
     }
-    
-    // If no legal moves, return nullptr (checkmate or stalemate)
-    if (!foundValidMove) {
-        return bestMove;
+
+    return previousPvLength > 0 ? previousPv[0] : PackedMove::None();
+}
+
+int AI::Search(Board& board, int depth, int ply, int alpha, int beta) {
+    // Base case: reached depth limit, only captures are looked at from here
+    if (depth <= 0) {
+        return Quiescence(board, ply, alpha, beta);
     }
-    
-    // Evaluate each move using minimax
-    for (const auto& [piece, moves] : possibleMovesPerPiece) {
-        for (const Move& move : moves) {
-            // Create a copy of the board
-            Board boardCopy = board;
-            Piece* pieceCopy = boardCopy.At(piece->GetPosition());
-            
-            // Make the move on the copied board
-            boardCopy.DoMove(pieceCopy, move);
-            
-            // Evaluate the position using minimax
-            int score = Minimax(boardCopy, MAX_DEPTH - 1, 
-                               std::numeric_limits<int>::min(), 
-                               std::numeric_limits<int>::max(), 
-                               false);
-            
-            // If this move has a better score, update the best move
-            if (score > bestScore) {
-                bestScore = score;
-                bestMove = {piece, move};
-            }
+
+    nodes++;
+    stack[ply].pvLength = 0;
+
+    if (ShouldStop()) {
+        return 0;
+    }
+
+    // Repetitions, the fifty-move rule and dead positions are draws, whatever the evaluation says
+    if (ply > 0 && board.IsDraw()) {
+        return 0;
+    }
+
+    const BoardState& state = board.GetState();
+    PIECE_COLOR color = state.sideToMove;
+
+    if (ply >= MAX_PLY - 1) {
+        return Evaluate(state, color);
+    }
+
+    bool isPvNode = beta - alpha > 1;
+    int originalAlpha = alpha;
+
+    TTData ttData;
+    bool ttHit = table.Probe(state.key, ttData);
+
+    if (ttHit) {
+        ttData.score = ScoreFromTable(ttData.score, ply);
+
+        // A deep enough earlier result settles the node, except on the principal variation,
+        // whose line has to be searched to be known
+        if (!isPvNode && ttData.depth >= depth && (
+            ttData.bound == B_EXACT ||
+            (ttData.bound == B_LOWER && ttData.score >= beta) ||
+            (ttData.bound == B_UPPER && ttData.score <= alpha)
+        )) {
+            return ttData.score;
         }
     }
-    
-    // Ensure we return a valid move if any exists
-    if (foundValidMove && bestMove.first == nullptr) {
-        // If we somehow didn't select a move but have valid moves,
-        // just take the first valid move we find
-        for (const auto& [piece, moves] : possibleMovesPerPiece) {
-            if (!moves.empty()) {
-                bestMove = {piece, moves[0]};
-                break;
+
+    int bestScore = -INFINITE_SCORE;
+    PackedMove bestMove = PackedMove::None();
+    int moveCount = 0;
+
+    // Quiet moves searched without a cutoff, penalized in the history if a later one cuts off
+    PackedMove quietsTried[64];
+    int quietCount = 0;
+
+    // The move of the previous iteration's best line goes first, otherwise the table's move
+    PackedMove pvMove = followingPv && ply < previousPvLength ? previousPv[ply] : PackedMove::None();
+    PackedMove hashMove = !pvMove.IsNone() ? pvMove : ttHit ? ttData.move : PackedMove::None();
+
+    MovePicker picker(state, color, hashMove, stack[ply].killers[0], stack[ply].killers[1], &history);
+
+    for (PackedMove move = picker.Next(); !move.IsNone(); move = picker.Next()) {
+        moveCount++;
+        followingPv = followingPv && moveCount == 1 && move == pvMove;
+        board.MakeMove(move);
+
+        int score;
+
+        if (moveCount == 1) {
+            score = -Search(board, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            score = -Search(board, depth - 1, ply + 1, -alpha - 1, -alpha);
+
+            // The move may be better after all: find out by how much
+            if (score > alpha && score < beta) {
+                score = -Search(board, depth - 1, ply + 1, -beta, -alpha);
             }
         }
-    }
-    
-    return bestMove;
-}
 
-int AI::Minimax(Board& board, int depth, int alpha, int beta, bool isMaximizing) {
-    // Base case: reached depth limit or game ended
-    if (depth == 0) {
-        return EvaluateBoard(board);
-    }
-    
-    PIECE_COLOR currentColor = isMaximizing ? aiColor : Piece::GetInverseColor(aiColor);
-    std::vector<Piece*> pieces = board.GetPiecesByColor(currentColor);
-    
-    if (isMaximizing) {
-        int maxEval = std::numeric_limits<int>::min();
-        
-        // For each piece of the current player
-        for (Piece* piece : pieces) {
-            std::vector<Move> moves = piece->GetPossibleMoves(board);
-            
-            // Filter invalid moves
-            for (int i = moves.size() - 1; i >= 0; i--) {
-                if (board.MoveLeadsToCheck(piece, moves[i])) {
-                    moves.erase(moves.begin() + i);
+        board.UnmakeMove();
+
+        // The score of an interrupted search means nothing
+        if (stopped) {
+            return 0;
+        }
+
+        bool isQuiet = !move.IsCapture() && !move.IsPromotion();
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+
+            if (score > alpha) {
+                alpha = score;
+
+                if (isPvNode) {
+                    UpdatePv(ply, move);
                 }
-            }
-            
-            // For each valid move
-            for (const Move& move : moves) {
-                // Create a copy of the board
-                Board boardCopy = board;
-                Piece* pieceCopy = boardCopy.At(piece->GetPosition());
-                
-                // Make the move
-                boardCopy.DoMove(pieceCopy, move);
-                
-                // Recursive evaluation
-                int eval = Minimax(boardCopy, depth - 1, alpha, beta, false);
-                maxEval = std::max(maxEval, eval);
-                
+
                 // Alpha-beta pruning
-                alpha = std::max(alpha, eval);
-                if (beta <= alpha) {
+                if (alpha >= beta) {
+                    cutoffs++;
+                    firstMoveCutoffs += moveCount == 1;
+
+                    if (isQuiet) {
+                        StoreKiller(ply, move);
+                        UpdateHistory(color, move, quietsTried, quietCount, depth);
+                    }
                     break;
                 }
             }
-            
-            // Early cutoff
-            if (beta <= alpha) {
-                break;
-            }
         }
-        
-        return maxEval;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
-        
-        // For each piece of the opponent
-        for (Piece* piece : pieces) {
-            std::vector<Move> moves = piece->GetPossibleMoves(board);
-            
-            // Filter invalid moves
-            for (int i = moves.size() - 1; i >= 0; i--) {
-                if (board.MoveLeadsToCheck(piece, moves[i])) {
-                    moves.erase(moves.begin() + i);
-                }
+
+        if (isQuiet && quietCount < 64) {
+            quietsTried[quietCount++] = move;
+        }
+    }
+
+    // No legal moves: checkmate or stalemate
+    if (moveCount == 0) {
+        return state.IsInCheck(color) ? -MATE_SCORE + ply : 0;
+    }
+
+    // Failing low says nothing about which move is best
+    BOUND_TYPE bound = bestScore >= beta ? B_LOWER : bestScore > originalAlpha ? B_EXACT : B_UPPER;
+    table.Store(state.key, bound == B_UPPER ? PackedMove::None() : bestMove, ScoreToTable(bestScore, ply), depth, bound);
+
+    return bestScore;
+}
+
+int AI::Quiescence(Board& board, int ply, int alpha, int beta) {
+    nodes++;
+    stack[ply].pvLength = 0;
+
+    if (ShouldStop()) {
+        return 0;
+    }
+
+    if (board.IsDraw()) {
+        return 0;
+    }
+
+    const BoardState& state = board.GetState();
+    PIECE_COLOR color = state.sideToMove;
+    bool isInCheck = state.IsInCheck(color);
+
+    stack[ply].staticEval = Evaluate(state, color);
+
+    if (ply >= MAX_PLY - 1) {
+        return stack[ply].staticEval;
+    }
+
+    int bestScore = -INFINITE_SCORE;
+
+    // Stand pat: the side to move is not forced to capture, so the evaluation is a lower
+    // bound, unless it is in check and has to get out of it
+    if (!isInCheck) {
+        bestScore = stack[ply].staticEval;
+
+        if (bestScore >= beta) {
+            return bestScore;
+        }
+
+        alpha = std::max(alpha, bestScore);
+    }
+
+    int moveCount = 0;
+    MovePicker picker(state, color, G_CAPTURES, &history);
+
+    for (PackedMove move = picker.Next(); !move.IsNone(); move = picker.Next()) {
+        moveCount++;
+
+        // Delta pruning: a capture that cannot bring the score up to alpha even with a margin
+        // for the positional change is not worth searching
+        if (!isInCheck && !move.IsPromotion()) {
+            PIECE_TYPE victim = move.Flag() == F_EN_PASSANT ? PIECE_TYPE::PEON : state.TypeAt(move.To());
+
+            if (stack[ply].staticEval + GetPieceValue(victim) + DELTA_MARGIN <= alpha) {
+                continue;
             }
-            
-            // For each valid move
-            for (const Move& move : moves) {
-                // Create a copy of the board
-                Board boardCopy = board;
-                Piece* pieceCopy = boardCopy.At(piece->GetPosition());
-                
-                // Make the move
-                boardCopy.DoMove(pieceCopy, move);
-                
-                // Recursive evaluation
-                int eval = Minimax(boardCopy, depth - 1, alpha, beta, true);
-                minEval = std::min(minEval, eval);
-                
-                // Alpha-beta pruning
-                beta = std::min(beta, eval);
-                if (beta <= alpha) {
+        }
+
+        board.MakeMove(move);
+        int score = -Quiescence(board, ply + 1, -beta, -alpha);
+        board.UnmakeMove();
+
+        if (stopped) {
+            return 0;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+
+            if (score > alpha) {
+                alpha = score;
+                UpdatePv(ply, move);
+
+                if (alpha >= beta) {
                     break;
                 }
             }
-            
-            // Early cutoff
-            if (beta <= alpha) {
-                break;
-            }
         }
-        
-        return minEval;
     }
+
+    // In check, the picker hands out every evasion: none means checkmate
+    if (isInCheck && moveCount == 0) {
+        return -MATE_SCORE + ply;
+    }
+
+    return bestScore;
 }
 
-int AI::EvaluateBoard(const Board& board) {
-    int score = 0;
-    
-    // Get all pieces
-    std::vector<Piece*> aiPieces = board.GetPiecesByColor(aiColor);
-    std::vector<Piece*> opponentPieces = board.GetPiecesByColor(Piece::GetInverseColor(aiColor));
-    
-    // Calculate material and positional advantage for AI pieces
-    for (Piece* piece : aiPieces) {
-        score += GetPieceValue(piece->type);
-        score += GetPositionalScore(piece);
+void AI::UpdatePv(int ply, PackedMove move) {
+    SearchStackEntry& entry = stack[ply];
+    const SearchStackEntry& next = stack[ply + 1];
+
+    entry.pv[0] = move;
+    std::copy(next.pv, next.pv + next.pvLength, entry.pv + 1);
+    entry.pvLength = next.pvLength + 1;
+}
+
+void AI::UpdateHistory(PIECE_COLOR color, PackedMove bestMove, const PackedMove* quietsTried, int quietCount, int depth) {
+    int bonus = depth * depth;
+
+    history.Update(color, bestMove, bonus);
+
+    for (int i = 0; i < quietCount; i++) {
+        history.Update(color, quietsTried[i], -bonus);
     }
-    
-    // Calculate material and positional advantage for opponent pieces (subtract)
-    for (Piece* piece : opponentPieces) {
-        score -= GetPieceValue(piece->type);
-        score -= GetPositionalScore(piece);
+}
+
+bool AI::ShouldStop() {
+    // The first iteration always finishes, so there is a move to play
+    if (hasDeadline && completedDepth > 0 && (nodes & 2047) == 0 && std::chrono::steady_clock::now() >= deadline) {
+        stopped = true;
+    }
+
+    return stopped;
+}
+
+void AI::StoreKiller(int ply, PackedMove move) {
+    PackedMove* killers = stack[ply].killers;
+
+    if (killers[0] != move) {
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+}
+
+int AI::Evaluate(const BoardState& state, PIECE_COLOR color) const {
+    int score = 0;
+    PIECE_COLOR opponentColor = Piece::GetInverseColor(color);
+
+    // Calculate material and positional advantage for the side's pieces, minus the opponent's.
+    for (int type = PIECE_TYPE::PEON; type <= PIECE_TYPE::KING; type++) {
+        PIECE_TYPE pieceType = static_cast<PIECE_TYPE>(type);
+
+        Bitboard ownPieces = state.GetPieces(color, pieceType);
+        Bitboard opponentPieces = state.GetPieces(opponentColor, pieceType);
+
+        score += GetPieceValue(pieceType) * (Bitboards::PopCount(ownPieces) - Bitboards::PopCount(opponentPieces));
+
+        while (ownPieces) {
+            score += GetPositionalScore(pieceType, color, Bitboards::PopLowestSquare(ownPieces));
+        }
+
+        while (opponentPieces) {
+            score -= GetPositionalScore(pieceType, opponentColor, Bitboards::PopLowestSquare(opponentPieces));
+        }
     }
     
     // Check for check/checkmate situations
-    if (board.IsInCheck(Piece::GetInverseColor(aiColor))) {
+    if (state.IsInCheck(opponentColor)) {
         score += 50; // Bonus for putting opponent in check
     }
     
-    if (board.IsInCheck(aiColor)) {
+    if (state.IsInCheck(color)) {
         score -= 50; // Penalty for being in check
     }
     
@@ -224,17 +385,17 @@ int AI::GetPieceValue(PIECE_TYPE type) const {
     }
 }
 
-int AI::GetPositionalScore(Piece* piece) const {
-    Position pos = piece->GetPosition();
+int AI::GetPositionalScore(PIECE_TYPE type, PIECE_COLOR color, int square) const {
+    Position pos = Bitboards::PositionOf(square);
     int row = pos.i;
     int col = pos.j;
     
     // For black pieces, mirror the table vertically
-    if (piece->color == PIECE_COLOR::C_BLACK) {
+    if (color == PIECE_COLOR::C_BLACK) {
         row = 7 - row;
     }
     
-    switch (piece->type) {
+    switch (type) {
         case PIECE_TYPE::PEON:
             return pawnTable[row][col];
         case PIECE_TYPE::KNIGHT:
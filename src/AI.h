@@ -3,33 +3,127 @@
 #define RAY_CHESS_AI_H
 
 #include "Board.h"
+#include "MovePicker.h"
+#include "TranspositionTable.h"
 #include "pieces/Piece.h"
+#include <chrono>
 #include <vector>
 #include <map>
 #include <utility>
 
 class AI {
 public:
-    AI(PIECE_COLOR aiColor);
+    // Longest line the search follows from the root.
+    static const int MAX_PLY = 64;
+
+    // Scores are in centipawns for the side to move. Mates are scored MATE_SCORE minus the
+    // number of plies to the mate, so a quicker mate scores higher.
+    static const int INFINITE_SCORE = 32000;
+    static const int MATE_SCORE = 31000;
+
+    // Time budget for searches that are only limited by depth.
+    static const int NO_TIME_LIMIT = -1;
+
+    static const size_t DEFAULT_HASH_MB = 16;
+
+    AI(PIECE_COLOR aiColor, size_t hashMegabytes = DEFAULT_HASH_MB);
     
-    // Main function to get the best move for the AI
-    std::pair<Piece*, Move> GetBestMove(Board& board);
+    // Main function to get the best move for the AI: searches depth 1, 2, 3... up to maxDepth
+    // until the time budget runs out and returns the best move of the deepest search that
+    // finished. The first depth is always finished, whatever the budget.
+    // PackedMove::None() if the AI has no legal move.
+    PackedMove GetBestMove(Board& board, int maxDepth, int timeBudgetMs = NO_TIME_LIMIT);
+
+    // Evaluate a position for one side
+    int Evaluate(const BoardState& state, PIECE_COLOR color) const;
+
+    // Positions visited by the last search.
+    long GetNodeCount() const {
+        return nodes;
+    }
+
+    // Deepest iteration the last search finished, and its score.
+    int GetCompletedDepth() const {
+        return completedDepth;
+    }
+
+    int GetScore() const {
+        return completedScore;
+    }
+
+    // Share of the last search's beta cutoffs made by the first move searched, a measure of how
+    // good the move ordering is.
+    double GetFirstMoveCutoffRate() const {
+        return cutoffs > 0 ? double(firstMoveCutoffs) / cutoffs : 0;
+    }
+
+    // How full the transposition table is with entries of the last search, in permille.
+    int GetHashFull() const {
+        return table.GetHashFull();
+    }
     
 private:
+    // What the search keeps about each ply of the line it is on. The stack is part of the AI,
+    // so searching allocates nothing.
+    struct SearchStackEntry {
+        // Best line found from this ply on; pv[0] is the move played here.
+        PackedMove pv[MAX_PLY];
+        int pvLength;
+        // Evaluation of the position, set where the search stands pat on it (quiescence).
+        int staticEval;
+        // Quiet moves that last caused a cutoff at this ply, tried early in sibling positions.
+        PackedMove killers[2];
+    };
+
     PIECE_COLOR aiColor;
-    const int MAX_DEPTH = 1; // Reduced from 2 to 1 for immediate response
-    
-    // Min-Max algorithm with alpha-beta pruning
-    int Minimax(Board& board, int depth, int alpha, int beta, bool isMaximizing);
+
+    // Most the evaluation can change by, apart from the captured piece, in a capture.
+    static const int DELTA_MARGIN = 200;
     
-    // Evaluate board position
-    int EvaluateBoard(const Board& board);
+    // Negamax principal variation search with alpha-beta pruning. The first move of a node is
+    // searched with the full window; the others only have to be proven no better, with a
+    // null window, and are searched again in full if that fails.
+    int Search(Board& board, int depth, int ply, int alpha, int beta);
+    // Search at the horizon: only captures and promotions (all evasions when in check), until
+    // the position is quiet, so the evaluation is never taken in the middle of an exchange.
+    int Quiescence(Board& board, int ply, int alpha, int beta);
+    // Makes move followed by the best line of the next ply the best line of this one.
+    void UpdatePv(int ply, PackedMove move);
+    void StoreKiller(int ply, PackedMove move);
+    // Rewards the quiet move that caused a cutoff and penalizes the quiet moves searched before it.
+    void UpdateHistory(PIECE_COLOR color, PackedMove bestMove, const PackedMove* quietsTried, int quietCount, int depth);
+    // Whether the search has to give up, checked every few thousand nodes.
+    bool ShouldStop();
+
+    SearchStackEntry stack[MAX_PLY + 1];
+    long nodes = 0;
+    long cutoffs = 0;
+    long firstMoveCutoffs = 0;
+
+    // Quiet move ordering, kept for the whole of a move's search.
+    HistoryTable history;
+
+    // Results of earlier searches, kept between moves.
+    TranspositionTable table;
+
+    // Best line of the last finished iteration. Each iteration searches it first, and keeps
+    // followingPv set while the moves played so far are the start of it.
+    PackedMove previousPv[MAX_PLY];
+    int previousPvLength = 0;
+    bool followingPv = false;
+
+    int completedDepth = 0;
+    int completedScore = 0;
+
+    bool hasDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    bool stopped = false;
     
     // Calculate material value for a piece
     int GetPieceValue(PIECE_TYPE type) const;
     
     // Calculate positional score for a piece
-    int GetPositionalScore(Piece* piece) const;
+    int GetPositionalScore(PIECE_TYPE type, PIECE_COLOR color, int square) const;
     
     // Piece tables for positional evaluation
     const int pawnTable[8][8] = {
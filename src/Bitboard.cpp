@@ -0,0 +1,249 @@
+#include "Bitboard.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // Magic numbers found offline by random search. With shift 64 - popcount(mask), each one maps
+    // every blocker subset of its square's mask to an index without destructive collisions.
+    const Bitboard ROOK_MAGIC_NUMBERS[64] = {
+        0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+        0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+        0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+        0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+        0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+        0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+        0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+        0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+        0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+        0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+        0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+        0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+        0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+        0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+        0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+        0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+    };
+
+    const Bitboard BISHOP_MAGIC_NUMBERS[64] = {
+        0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+        0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+        0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+        0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+        0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+        0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+        0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+        0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+        0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+        0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+        0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+        0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+        0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+        0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+        0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+        0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+    };
+
+    // Rank and file steps of the slider directions: four rook directions followed by four bishop
+    // ones, each next to its opposite.
+    const int DIRECTIONS[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+    const bool INCREASING[8] = {true, false, true, false, true, false, true, false};
+    const int ROOK_FIRST_DIRECTION = 0;
+    const int BISHOP_FIRST_DIRECTION = 4;
+
+    // Empty-board ray from each square in each direction.
+    Bitboard rays[8][64];
+
+    // Shared by all squares: 102400 rook entries and 5248 bishop entries.
+    Bitboard rookAttackTable[102400];
+    Bitboard bishopAttackTable[5248];
+
+    Bitboard Ray(int square, int rankStep, int fileStep) {
+        Bitboard attacks = 0;
+        int rank = square / 8 + rankStep;
+        int file = square % 8 + fileStep;
+
+        while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+            attacks |= Bitboards::SquareBit(rank * 8 + file);
+            rank += rankStep;
+            file += fileStep;
+        }
+
+        return attacks;
+    }
+
+    // Attacks along one ray, cut off behind its nearest blocker.
+    Bitboard BlockedRay(int direction, int square, Bitboard occupied) {
+        Bitboard ray = rays[direction][square];
+        Bitboard blockers = ray & occupied;
+
+        if (blockers) {
+            // Rays stepping up the board (or right along a rank) grow towards higher squares.
+            int blocker = INCREASING[direction] ? Bitboards::LowestSquare(blockers) : Bitboards::HighestSquare(blockers);
+            ray &= ~rays[direction][blocker];
+        }
+
+        return ray;
+    }
+
+    // Squares whose occupancy can change the slider's attacks: every ray square except the last one.
+    Bitboard RelevantOccupancy(int square, int firstDirection) {
+        Bitboard mask = 0;
+
+        for (int direction = firstDirection; direction < firstDirection + 4; direction++) {
+            int rankStep = DIRECTIONS[direction][0];
+            int fileStep = DIRECTIONS[direction][1];
+            int rank = square / 8 + rankStep;
+            int file = square % 8 + fileStep;
+
+            while (rank + rankStep >= 0 && rank + rankStep < 8 && file + fileStep >= 0 && file + fileStep < 8) {
+                mask |= Bitboards::SquareBit(rank * 8 + file);
+                rank += rankStep;
+                file += fileStep;
+            }
+        }
+
+        return mask;
+    }
+
+    template <int firstDirection>
+    void InitSliderEntries(Bitboards::SliderEntry (&entries)[64], Bitboard* table, const Bitboard (&magicNumbers)[64]) {
+        for (int square = 0; square < 64; square++) {
+            Bitboards::SliderEntry& entry = entries[square];
+
+            entry.mask = RelevantOccupancy(square, firstDirection);
+            entry.magic = magicNumbers[square];
+            entry.shift = 64 - Bitboards::PopCount(entry.mask);
+            entry.attacks = table;
+
+            // The four rays split the mask into disjoint parts, and each part only blocks its own
+            // ray. Enumerate the subsets of each part once (Carry-Rippler) with their blocked ray,
+            // then every subset of the mask is a union of one subset per part and so are its attacks.
+            Bitboard subsets[4][64];
+            Bitboard attacks[4][64];
+            int counts[4];
+
+            for (int ray = 0; ray < 4; ray++) {
+                Bitboard part = rays[firstDirection + ray][square] & entry.mask;
+                Bitboard subset = 0;
+                counts[ray] = 0;
+
+                do {
+                    subsets[ray][counts[ray]] = subset;
+                    attacks[ray][counts[ray]++] = BlockedRay(firstDirection + ray, square, subset);
+                    subset = (subset - part) & part;
+                } while (subset);
+            }
+
+            for (int a = 0; a < counts[0]; a++) {
+                for (int b = 0; b < counts[1]; b++) {
+                    for (int c = 0; c < counts[2]; c++) {
+                        Bitboard subset = subsets[0][a] | subsets[1][b] | subsets[2][c];
+                        Bitboard attacked = attacks[0][a] | attacks[1][b] | attacks[2][c];
+
+                        for (int d = 0; d < counts[3]; d++) {
+                            table[entry.Index(subset | subsets[3][d])] = attacked | attacks[3][d];
+                        }
+                    }
+                }
+            }
+
+            table += Bitboard(1) << Bitboards::PopCount(entry.mask);
+        }
+    }
+
+    Bitboards::ATTACK_BACKEND DefaultAttackBackend() {
+#if defined(RAY_CHESS_ATTACKS_MAGIC)
+        return Bitboards::B_MAGIC;
+#elif defined(RAY_CHESS_ATTACKS_PEXT)
+        return Bitboards::B_PEXT;
+#else
+        const char* requested = std::getenv("RAY_CHESS_ATTACKS");
+
+        if (requested && std::strcmp(requested, "magic") == 0) {
+            return Bitboards::B_MAGIC;
+        }
+
+        if (requested && std::strcmp(requested, "pext") == 0 && Bitboards::IsPextSupported()) {
+            return Bitboards::B_PEXT;
+        }
+
+        return Bitboards::IsPextSupported() ? Bitboards::B_PEXT : Bitboards::B_MAGIC;
+#endif
+    }
+
+    struct SliderAttacksInitializer {
+        SliderAttacksInitializer() {
+            Bitboards::InitSliderAttacks();
+        }
+    } sliderAttacksInitializer;
+}
+
+// a1 reaches b3 and c2; a white pawn on e2 attacks d3 and f3.
+static_assert(Bitboards::KnightAttacks(0) == (Bitboards::SquareBit(17) | Bitboards::SquareBit(10)), "knight table");
+static_assert(Bitboards::PawnAttacks(PIECE_COLOR::C_WHITE, 12) == (Bitboards::SquareBit(19) | Bitboards::SquareBit(21)), "pawn table");
+
+Bitboards::ATTACK_BACKEND Bitboards::attackBackend = Bitboards::B_MAGIC;
+Bitboards::SliderEntry Bitboards::rookEntries[64];
+Bitboards::SliderEntry Bitboards::bishopEntries[64];
+
+bool Bitboards::IsPextSupported() {
+#if defined(RAY_CHESS_ATTACKS_MAGIC)
+    return false;
+#elif defined(__BMI2__)
+    return true;
+#elif defined(__x86_64__)
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+Bitboard Bitboards::betweenTable[64][64];
+Bitboard Bitboards::lineTable[64][64];
+
+void Bitboards::InitSliderAttacks() {
+    for (int direction = 0; direction < 8; direction++) {
+        for (int square = 0; square < 64; square++) {
+            rays[direction][square] = Ray(square, DIRECTIONS[direction][0], DIRECTIONS[direction][1]);
+        }
+    }
+
+    // Directions come in opposite pairs (0/1, 2/3, ...), which together span a full line.
+    for (int direction = 0; direction < 8; direction++) {
+        int opposite = direction ^ 1;
+
+        for (int from = 0; from < 64; from++) {
+            Bitboard ray = rays[direction][from];
+
+            while (ray) {
+                int to = PopLowestSquare(ray);
+
+                betweenTable[from][to] = rays[direction][from] & ~rays[direction][to] & ~SquareBit(to);
+                lineTable[from][to] = rays[direction][from] | rays[opposite][from] | SquareBit(from);
+            }
+        }
+    }
+
+    SetAttackBackend(DefaultAttackBackend());
+}
+
+bool Bitboards::SetAttackBackend(ATTACK_BACKEND backend) {
+#if defined(RAY_CHESS_ATTACKS_MAGIC)
+    if (backend != B_MAGIC) return false;
+#elif defined(RAY_CHESS_ATTACKS_PEXT)
+    if (backend != B_PEXT) return false;
+#endif
+
+    if (backend == B_PEXT && !IsPextSupported()) {
+        return false;
+    }
+
+    // Both backends index the same tables, so they have to be refilled in the new order.
+    attackBackend = backend;
+
+    InitSliderEntries<ROOK_FIRST_DIRECTION>(rookEntries, rookAttackTable, ROOK_MAGIC_NUMBERS);
+    InitSliderEntries<BISHOP_FIRST_DIRECTION>(bishopEntries, bishopAttackTable, BISHOP_MAGIC_NUMBERS);
+
+    return true;
+}
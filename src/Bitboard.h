@@ -0,0 +1,243 @@
+#ifndef RAY_CHESS_BITBOARD_H
+#define RAY_CHESS_BITBOARD_H
+
+#include "Position.h"
+#include "pieces/PieceEnums.h"
+
+#include <array>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Slider lookups default to picking the backend at startup. Building with
+// RAY_CHESS_ATTACKS_MAGIC or RAY_CHESS_ATTACKS_PEXT (the latter needs -mbmi2)
+// compiles in a single backend instead.
+#if defined(RAY_CHESS_ATTACKS_PEXT) && !defined(__BMI2__)
+#error "RAY_CHESS_ATTACKS_PEXT requires a BMI2 target (-mbmi2)"
+#endif
+
+// A set of squares, one bit per square. Square 0 is a1 and square 63 is h8,
+// so the board position {i, j} maps to square (7 - i) * 8 + j.
+typedef uint64_t Bitboard;
+
+namespace Bitboards {
+    const Bitboard FILE_A = 0x0101010101010101ULL;
+    const Bitboard FILE_H = FILE_A << 7;
+    const Bitboard RANK_1 = 0xFFULL;
+    const Bitboard RANK_8 = RANK_1 << 56;
+    // a1, c1, ..., b2, d2, ...
+    const Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+    // Moves every square of the set by offset squares (up the board when positive). Squares
+    // pushed off the top or bottom are dropped; callers mask out file wrap-around.
+    template <int Offset>
+    inline Bitboard Shift(Bitboard set) {
+        if constexpr (Offset > 0) {
+            return set << Offset;
+        } else {
+            return set >> -Offset;
+        }
+    }
+
+    constexpr int SquareOf(const Position& position) {
+        return (7 - position.i) * 8 + position.j;
+    }
+
+    constexpr Position PositionOf(int square) {
+        return {7 - square / 8, square % 8};
+    }
+
+    constexpr Bitboard SquareBit(int square) {
+        return 1ULL << square;
+    }
+
+    inline int PopCount(Bitboard set) {
+        return __builtin_popcountll(set);
+    }
+
+    // Index of the lowest set square. The set must not be empty.
+    inline int LowestSquare(Bitboard set) {
+        return __builtin_ctzll(set);
+    }
+
+    // Index of the highest set square. The set must not be empty.
+    inline int HighestSquare(Bitboard set) {
+        return 63 - __builtin_clzll(set);
+    }
+
+    inline int PopLowestSquare(Bitboard& set) {
+        int square = LowestSquare(set);
+        set &= set - 1;
+        return square;
+    }
+
+    enum ATTACK_BACKEND {
+        B_MAGIC,
+        B_PEXT
+    };
+
+    extern ATTACK_BACKEND attackBackend;
+
+    // Packs the bits of set selected by mask into the low bits (the BMI2 PEXT instruction).
+    // Only valid on CPUs with BMI2; callers go through the B_PEXT backend.
+    inline Bitboard ExtractBits(Bitboard set, Bitboard mask) {
+#if defined(__BMI2__)
+        return _pext_u64(set, mask);
+#elif defined(__x86_64__)
+        // Emitted directly so the portable build can still dispatch to it at runtime.
+        Bitboard result;
+        asm("pextq %2, %1, %0" : "=r"(result) : "r"(set), "r"(mask));
+        return result;
+#else
+        (void) set;
+        (void) mask;
+        return 0;
+#endif
+    }
+
+    // Slider lookup for one square. The occupancy bits that can block the slider (mask) are
+    // turned into an index into the square's attack table, either by multiplying with a magic
+    // number and keeping the top bits, or by extracting them with PEXT.
+    struct SliderEntry {
+        Bitboard mask;
+        Bitboard magic;
+        const Bitboard* attacks;
+        unsigned shift;
+
+        unsigned MagicIndex(Bitboard occupied) const {
+            return unsigned(((occupied & mask) * magic) >> shift);
+        }
+
+        unsigned PextIndex(Bitboard occupied) const {
+            return unsigned(ExtractBits(occupied, mask));
+        }
+
+        unsigned Index(Bitboard occupied) const {
+#if defined(RAY_CHESS_ATTACKS_MAGIC)
+            return MagicIndex(occupied);
+#elif defined(RAY_CHESS_ATTACKS_PEXT)
+            return PextIndex(occupied);
+#else
+            return attackBackend == B_PEXT ? PextIndex(occupied) : MagicIndex(occupied);
+#endif
+        }
+    };
+
+    extern SliderEntry rookEntries[64];
+    extern SliderEntry bishopEntries[64];
+
+    // Whether this CPU (and build) can run the PEXT backend.
+    bool IsPextSupported();
+
+    // Fills the between and line tables, then the slider attack tables for the backend chosen
+    // at startup: the build option if given, else the RAY_CHESS_ATTACKS environment variable
+    // ("magic" or "pext"), else PEXT when the CPU supports it. Runs once during static initialization.
+    void InitSliderAttacks();
+
+    // Switches backend and refills the tables. Returns false if the backend is unavailable.
+    bool SetAttackBackend(ATTACK_BACKEND backend);
+
+    // Squares reached from a square by the given (rank, file) steps, dropping those off the board.
+    template <int N>
+    constexpr Bitboard StepAttacks(int square, const int (&steps)[N][2]) {
+        Bitboard attacks = 0;
+
+        for (int k = 0; k < N; k++) {
+            int rank = square / 8 + steps[k][0];
+            int file = square % 8 + steps[k][1];
+
+            if (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                attacks |= SquareBit(rank * 8 + file);
+            }
+        }
+
+        return attacks;
+    }
+
+    template <int N>
+    constexpr std::array<Bitboard, 64> StepAttackTable(const int (&steps)[N][2]) {
+        std::array<Bitboard, 64> table = {};
+
+        for (int square = 0; square < 64; square++) {
+            table[square] = StepAttacks(square, steps);
+        }
+
+        return table;
+    }
+
+    constexpr int KNIGHT_STEPS[8][2] = {{-2, -1}, {-2, 1}, {-1, 2}, {1, 2}, {2, -1}, {2, 1}, {-1, -2}, {1, -2}};
+    constexpr int KING_STEPS[8][2] = {{-1, 0}, {1, 0}, {0, 1}, {0, -1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    // White pawns attack up the board (towards rank 8), black pawns down.
+    constexpr int PAWN_STEPS[2][2][2] = {{{1, -1}, {1, 1}}, {{-1, -1}, {-1, 1}}};
+
+    // Leaper attack tables, built by the compiler.
+    inline constexpr std::array<Bitboard, 64> KNIGHT_ATTACKS = StepAttackTable(KNIGHT_STEPS);
+    inline constexpr std::array<Bitboard, 64> KING_ATTACKS = StepAttackTable(KING_STEPS);
+    inline constexpr std::array<Bitboard, 64> PAWN_ATTACKS[2] = {
+        StepAttackTable(PAWN_STEPS[PIECE_COLOR::C_WHITE]),
+        StepAttackTable(PAWN_STEPS[PIECE_COLOR::C_BLACK])
+    };
+
+    // Attack sets. Sliders stop at (and include) the first occupied square on each ray.
+    constexpr Bitboard PawnAttacks(PIECE_COLOR color, int square) {
+        return PAWN_ATTACKS[color][square];
+    }
+
+    constexpr Bitboard KnightAttacks(int square) {
+        return KNIGHT_ATTACKS[square];
+    }
+
+    constexpr Bitboard KingAttacks(int square) {
+        return KING_ATTACKS[square];
+    }
+
+    inline Bitboard RookAttacks(int square, Bitboard occupied) {
+        const SliderEntry& entry = rookEntries[square];
+        return entry.attacks[entry.Index(occupied)];
+    }
+
+    inline Bitboard BishopAttacks(int square, Bitboard occupied) {
+        const SliderEntry& entry = bishopEntries[square];
+        return entry.attacks[entry.Index(occupied)];
+    }
+
+    inline Bitboard QueenAttacks(int square, Bitboard occupied) {
+        return RookAttacks(square, occupied) | BishopAttacks(square, occupied);
+    }
+
+    // Attack set of a knight, bishop, rook, queen or king, picked at compile time so generators
+    // templated on the piece type inline a single lookup.
+    template <PIECE_TYPE Type>
+    inline Bitboard Attacks(int square, Bitboard occupied) {
+        static_assert(Type != PIECE_TYPE::PEON, "pawn attacks depend on the color");
+
+        if constexpr (Type == PIECE_TYPE::KNIGHT) {
+            return KnightAttacks(square);
+        } else if constexpr (Type == PIECE_TYPE::BISHOP) {
+            return BishopAttacks(square, occupied);
+        } else if constexpr (Type == PIECE_TYPE::ROOK) {
+            return RookAttacks(square, occupied);
+        } else if constexpr (Type == PIECE_TYPE::QUEEN) {
+            return QueenAttacks(square, occupied);
+        } else {
+            return KingAttacks(square);
+        }
+    }
+
+    extern Bitboard betweenTable[64][64];
+    extern Bitboard lineTable[64][64];
+
+    // Squares strictly between two squares on a shared rank, file or diagonal; empty otherwise.
+    inline Bitboard Between(int from, int to) {
+        return betweenTable[from][to];
+    }
+
+    // The whole rank, file or diagonal through two squares; empty if they are not aligned.
+    inline Bitboard Line(int from, int to) {
+        return lineTable[from][to];
+    }
+}
+
+#endif //RAY_CHESS_BITBOARD_H
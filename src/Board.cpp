@@ -6,20 +6,18 @@
 #include "pieces/Queen.h"
 #include "pieces/King.h"
 
+#include <algorithm>
 #include <string>
-#include <map>
 
-Board::Board(const Board& other) {
-    Clear();
-
-    for (Piece* whitePiece : other.whitePieces) {
-        Piece* newPiece = Piece::CreatePieceByType(whitePiece->type, whitePiece->GetPosition(), whitePiece->color);
-        Add(newPiece);
-    }
+Board::Board() {
+    state.Clear();
+}
 
-    for (Piece* blackPiece : other.blackPieces) {
-        Piece* newPiece = Piece::CreatePieceByType(blackPiece->type, blackPiece->GetPosition(), blackPiece->color);
-        Add(newPiece);
+Board::Board(const Board& other) : state(other.state), gameKeys(other.gameKeys) {
+    for (const std::vector<Piece*>* pieces : {&other.whitePieces, &other.blackPieces}) {
+        for (Piece* piece : *pieces) {
+            AddToPieces(Piece::CreatePieceByType(piece->type, piece->GetPosition(), piece->color));
+        }
     }
 }
 
@@ -61,50 +59,60 @@ void Board::Init() {
 
     Add(new Queen({7, 3}, PIECE_COLOR::C_WHITE));
     Add(new King({7, 4}, PIECE_COLOR::C_WHITE));
+
+    // White to move, as after Clear.
+    state.SetCastlingRights(CR_ALL);
 }
 
-Piece* Board::At(const Position& position) const {
-    if (!IsPositionWithinBoundaries(position)) return nullptr;
+bool Board::LoadFen(const std::string& fen, PIECE_COLOR& turn) {
+    Clear();
 
-    for (Piece* whitePiece : whitePieces) {
-        if (whitePiece->GetPosition().i == position.i && whitePiece->GetPosition().j == position.j) {
-            return whitePiece;
-        }
+    if (!state.LoadFen(fen)) {
+        return false;
     }
 
-    for (Piece* blackPiece : blackPieces) {
-        if (blackPiece->GetPosition().i == position.i && blackPiece->GetPosition().j == position.j) {
-            return blackPiece;
+    for (int square = 0; square < 64; square++) {
+        if (!state.IsEmpty(square)) {
+            AddToPieces(Piece::CreatePieceByType(state.TypeAt(square), Bitboards::PositionOf(square), state.ColorAt(square)));
         }
     }
 
-    return nullptr;
+    turn = state.sideToMove;
+    return true;
+}
+
+Piece* Board::At(const Position& position) const {
+    if (!IsPositionWithinBoundaries(position)) return nullptr;
+
+    return squares[Bitboards::SquareOf(position)];
+}
+
+Piece* Board::At(int square) const {
+    return squares[square];
 }
 
 void Board::Add(Piece* piece) {
-    if (piece->color == PIECE_COLOR::C_WHITE) {
-        whitePieces.push_back(piece);
-    } else {
-        blackPieces.push_back(piece);
-    }
+    state.PutPiece(piece->type, piece->color, Bitboards::SquareOf(piece->GetPosition()));
+    AddToPieces(piece);
 }
 
 void Board::Destroy(const Position& position) {
-    for (unsigned int i = 0; i < whitePieces.size(); i++) {
-        if (whitePieces[i]->GetPosition().i == position.i && whitePieces[i]->GetPosition().j == position.j) {
-            delete whitePieces[i];
-            whitePieces.erase(whitePieces.begin() + i);
-            return;
-        }
-    }
+    Piece* piece = At(position);
 
-    for (unsigned int i = 0; i < blackPieces.size(); i++) {
-        if (blackPieces[i]->GetPosition().i == position.i && blackPieces[i]->GetPosition().j == position.j) {
-            delete blackPieces[i];
-            blackPieces.erase(blackPieces.begin() + i);
-            return;
-        }
+    if (!piece) {
+        return;
     }
+
+    state.RemovePiece(Bitboards::SquareOf(position));
+    RemoveFromPieces(piece);
+    delete piece;
+}
+
+void Board::Promote(const Position& position, PIECE_TYPE type) {
+    PIECE_COLOR color = At(position)->color;
+
+    Destroy(position);
+    Add(Piece::CreatePieceByType(type, position, color));
 }
 
 void Board::Clear() {
@@ -118,6 +126,37 @@ void Board::Clear() {
 
     whitePieces.clear();
     blackPieces.clear();
+
+    for (Piece*& square : squares) {
+        square = nullptr;
+    }
+
+    state.Clear();
+    gameKeys.clear();
+    undoCount = 0;
+}
+
+void Board::AddToPieces(Piece* piece) {
+    squares[Bitboards::SquareOf(piece->GetPosition())] = piece;
+
+    if (piece->color == PIECE_COLOR::C_WHITE) {
+        whitePieces.push_back(piece);
+    } else {
+        blackPieces.push_back(piece);
+    }
+}
+
+void Board::RemoveFromPieces(Piece* piece) {
+    squares[Bitboards::SquareOf(piece->GetPosition())] = nullptr;
+
+    std::vector<Piece*>& pieces = piece->color == PIECE_COLOR::C_WHITE ? whitePieces : blackPieces;
+    pieces.erase(std::find(pieces.begin(), pieces.end(), piece));
+}
+
+void Board::RelocatePiece(Piece* piece, int square, const Move& move) {
+    squares[Bitboards::SquareOf(piece->GetPosition())] = nullptr;
+    squares[square] = piece;
+    piece->DoMove(move);
 }
 
 std::vector<Piece*> Board::GetPiecesByColor(PIECE_COLOR color) const {
@@ -128,79 +167,94 @@ std::vector<Piece*> Board::GetPiecesByColor(PIECE_COLOR color) const {
     }
 }
 
-Piece* Board::GetLastMovedPiece() const {
-    return At(lastMovedPiecePosition);
-}
-
 bool Board::IsPositionWithinBoundaries(const Position &position) const {
     return position.j >= 0 && position.j < 8 && position.i >= 0 && position.i < 8;
 }
 
 void Board::DoMove(Piece* piece, const Move& move) {
-    // Delete piece, if attack or en passant.
-    if (move.type == MOVE_TYPE::ATTACK || move.type == MOVE_TYPE::ATTACK_AND_PROMOTION) {
-        Destroy(move.position);
-    } else if (move.type == MOVE_TYPE::EN_PASSANT) {
-        Destroy({piece->GetPosition().i, move.position.j});
-    }
-
-    // Move piece. In case of castling, also move rook.
-    if (move.type == MOVE_TYPE::SHORT_CASTLING) {
-        DoShortCastling(piece, move);
-    } else if (move.type == MOVE_TYPE::LONG_CASTLING) {
-        DoLongCastling(piece, move);
-    } else {
-        // Swap positions.
-        piece->DoMove(move);
+    DoMove(PackedMove::Pack(Bitboards::SquareOf(piece->GetPosition()), move));
+}
+
+void Board::DoMove(PackedMove move) {
+    int from = move.From();
+    int to = move.To();
+    MOVE_FLAG flag = move.Flag();
+    Piece* piece = squares[from];
+
+    // Take the captured piece off the board; en passant takes the pawn beside the moving one.
+    if (move.IsCapture()) {
+        Piece* capturedPiece = squares[flag == F_EN_PASSANT ? (from & ~7) | (to & 7) : to];
+
+        RemoveFromPieces(capturedPiece);
+        delete capturedPiece;
     }
 
-    lastMovedPiecePosition = piece->GetPosition();
-}
+    // In case of castling, also move the rook next to the king.
+    if (flag == F_SHORT_CASTLING || flag == F_LONG_CASTLING) {
+        int rookFrom = flag == F_SHORT_CASTLING ? from + 3 : from - 4;
+        int rookTo = flag == F_SHORT_CASTLING ? from + 1 : from - 1;
 
-void Board::DoShortCastling(Piece* selectedPiece, const Move& move) {
-    Piece* rook = At({selectedPiece->GetPosition().i, 7});
+        RelocatePiece(squares[rookFrom], rookTo, {MOVE_TYPE::WALK, Bitboards::PositionOf(rookTo)});
+    }
 
-    selectedPiece->DoMove(move);
-    rook->DoMove({MOVE_TYPE::WALK, rook->GetPosition().i, rook->GetPosition().j - 2});
+    RelocatePiece(piece, to, move.ToMove());
+
+    if (move.IsPromotion()) {
+        RemoveFromPieces(piece);
+        AddToPieces(Piece::CreatePieceByType(move.PromotionType(), piece->GetPosition(), piece->color));
+        delete piece;
+    }
+
+    gameKeys.push_back(state.key);
+    state.MakeMove(move);
 }
 
-void Board::DoLongCastling(Piece* selectedPiece, const Move& move) {
-    Piece* rook = At({selectedPiece->GetPosition().i, 0});
+void Board::MakeMove(PackedMove move) {
+    undoStack[undoCount++] = state;
+    state.MakeMove(move);
+}
 
-    selectedPiece->DoMove(move);
-    rook->DoMove({MOVE_TYPE::WALK, rook->GetPosition().i, rook->GetPosition().j + 3});
+void Board::UnmakeMove() {
+    state = undoStack[--undoCount];
 }
 
-bool Board::MoveLeadsToCheck(Piece* piece, const Move& move) {
-    // Copy current board and current selected piece.
-    Board boardCopy = *this;
-    Piece* pieceInCopiedBoard = boardCopy.At(piece->GetPosition());
+int Board::CountRepetitions() const {
+    int repetitions = 0;
+    int plies = std::min(int(state.halfmoveClock), undoCount + int(gameKeys.size()));
 
-    // Perform the move.
-    boardCopy.DoMove(pieceInCopiedBoard, move);
+    // Positions with the same side to move are an even number of plies apart, and it takes
+    // at least two moves each to come back.
+    for (int ply = 4; ply <= plies; ply += 2) {
+        uint64_t key = ply <= undoCount ? undoStack[undoCount - ply].key : gameKeys[gameKeys.size() - (ply - undoCount)];
 
-    return boardCopy.IsInCheck(piece->color);
+        if (key == state.key) {
+            repetitions++;
+        }
+    }
+
+    return repetitions;
 }
 
-bool Board::IsInCheck(PIECE_COLOR color) const { 
-    std::vector<Piece*> enemyPieces = GetPiecesByColor(Piece::GetInverseColor(color));
+bool Board::IsDraw() const {
+    if (state.IsInsufficientMaterial() || CountRepetitions() > 0) {
+        return true;
+    }
 
-    for (Piece* piece : enemyPieces) {
-        for (const Move& move : piece->GetPossibleMoves(*this)) {
-            Piece* pieceAtMovePosition = At(move.position);
+    if (state.halfmoveClock < 100) {
+        return false;
+    }
 
-            bool movePositionContainsMyKing = pieceAtMovePosition &&
-                                              pieceAtMovePosition->color == color &&
-                                              pieceAtMovePosition->type == PIECE_TYPE::KING;
+    // A checkmate on the hundredth ply still stands.
+    MoveList moves;
+    state.GetLegalMoves(state.sideToMove, moves);
 
-            bool moveIsAttack = move.type == MOVE_TYPE::ATTACK || move.type == MOVE_TYPE::ATTACK_AND_PROMOTION;
+    return !moves.Empty() || !state.IsInCheck(state.sideToMove);
+}
 
-            // If the enemy piece is attacking my king, the king is in check.
-            if (movePositionContainsMyKing && moveIsAttack) {
-                return true;
-            }
-        }
-    }
+bool Board::MoveLeadsToCheck(Piece* piece, const Move& move) {
+    MakeMove(PackedMove::Pack(Bitboards::SquareOf(piece->GetPosition()), move));
+    bool leadsToCheck = IsInCheck(piece->color);
+    UnmakeMove();
 
-    return false;
+    return leadsToCheck;
 }
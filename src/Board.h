@@ -5,41 +5,112 @@ class Board;  // Forward declaration (circular dependency).
 
 #include "pieces/Piece.h"
 #include "pieces/PieceEnums.h"
+#include "Bitboard.h"
+#include "BoardState.h"
 #include "Move.h"
+#include "MoveList.h"
 #include "raylib.h"
 
 #include <map>
 #include <string>
 #include <vector>
 
+// The board of the game: the engine position (a BoardState) together with the piece objects
+// the game and renderer work with.
 class Board {
 public:
-    Board() = default;
+    Board();
     Board(const Board& other);
     ~Board();
 
     void Init();
+    // Sets up the position of a FEN string and stores its side to move in turn. Returns false
+    // (leaving the board empty) if the string cannot be read or the position cannot be played.
+    bool LoadFen(const std::string& fen, PIECE_COLOR& turn);
     Piece* At(const Position& position) const;
+    Piece* At(int square) const;
     void Add(Piece* piece);
     void Destroy(const Position &position);
+    // Replaces the piece on a square (a pawn that has just promoted) with a new piece of the
+    // given type and the same color.
+    void Promote(const Position& position, PIECE_TYPE type);
     void Clear();
 
     bool IsPositionWithinBoundaries(const Position& position) const;
     std::vector<Piece*> GetPiecesByColor(PIECE_COLOR color) const;
-    Piece* GetLastMovedPiece() const;
 
+    const BoardState& GetState() const {
+        return state;
+    }
+
+    // Queries on the current position, answered by the state.
+    Bitboard GetPieces(PIECE_COLOR color, PIECE_TYPE type) const {
+        return state.GetPieces(color, type);
+    }
+
+    Bitboard GetPieces(PIECE_COLOR color) const {
+        return state.GetPieces(color);
+    }
+
+    Bitboard GetOccupied() const {
+        return state.GetOccupied();
+    }
+
+    bool IsInCheck(PIECE_COLOR color) const {
+        return state.IsInCheck(color);
+    }
+
+    void GetLegalMoves(PIECE_COLOR color, MoveList& moves, GENERATION_TYPE type = G_ALL) const {
+        state.GetLegalMoves(color, moves, type);
+    }
+
+    void GetPseudoLegalMoves(PIECE_COLOR color, MoveList& moves, GENERATION_TYPE type = G_ALL) const {
+        state.GetPseudoLegalMoves(color, moves, type);
+    }
+
+    // Plays a move for good, moving the piece objects along (a promoted pawn is replaced by
+    // the piece the move names, a queen for an unpacked move).
     void DoMove(Piece* piece, const Move& move);
+    void DoMove(PackedMove move);
     bool MoveLeadsToCheck(Piece* piece, const Move& move);
-    bool IsInCheck(PIECE_COLOR color) const;
+
+    // Earlier occurrences of the current position with the same side to move, in the game
+    // and in the moves made since. Only the plies since the last capture or pawn move are
+    // looked at, as no earlier position can come back.
+    int CountRepetitions() const;
+    // Whether search can score the position as a draw without looking further: insufficient
+    // material, the fifty-move rule or any repetition. A side that could avoid a repetition
+    // would, so the first one counts.
+    bool IsDraw() const;
+
+    // Reversible moves for search: MakeMove pushes a copy of the state and plays the move on
+    // it, UnmakeMove pops the copy back. Only the state changes, so At and the piece lists
+    // keep showing the position before the first unpaired MakeMove. Calls must be paired, at
+    // most MAX_UNDO_DEPTH deep.
+    void MakeMove(PackedMove move);
+    void UnmakeMove();
+
+    static const int MAX_UNDO_DEPTH = 256;
 
 private:
-    void DoShortCastling(Piece* selectedPiece, const Move& move);
-    void DoLongCastling(Piece* selectedPiece, const Move& move);
+    // Piece object bookkeeping; the state is left alone.
+    void AddToPieces(Piece* piece);
+    void RemoveFromPieces(Piece* piece);
+    void RelocatePiece(Piece* piece, int square, const Move& move);
+
+    BoardState state;
 
     std::vector<Piece*> whitePieces;
     std::vector<Piece*> blackPieces;
 
-    Position lastMovedPiecePosition;
+    // Piece standing on each square (indexed like the bitboards), so At is a single load.
+    Piece* squares[64] = {};
+
+    // Keys of the positions the game went through, oldest first (the current one is not included).
+    std::vector<uint64_t> gameKeys;
+
+    BoardState undoStack[MAX_UNDO_DEPTH];
+    int undoCount = 0;
 };
 
 #endif //RAY_CHESS_BOARD_H
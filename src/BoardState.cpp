@@ -0,0 +1,791 @@
+#include "BoardState.h"
+#include "Zobrist.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+    constexpr PIECE_COLOR Opponent(PIECE_COLOR color) {
+        return PIECE_COLOR(color ^ 1);
+    }
+
+    // Rights that survive a move starting or ending on each square: moving a king or rook, or
+    // capturing a rook in its corner, drops the rights that need it.
+    constexpr std::array<uint8_t, 64> CastlingMasks() {
+        std::array<uint8_t, 64> masks = {};
+
+        for (uint8_t& mask : masks) {
+            mask = CR_ALL;
+        }
+
+        masks[0] = CR_ALL & ~CR_WHITE_LONG;
+        masks[4] = CR_ALL & ~(CR_WHITE_SHORT | CR_WHITE_LONG);
+        masks[7] = CR_ALL & ~CR_WHITE_SHORT;
+        masks[56] = CR_ALL & ~CR_BLACK_LONG;
+        masks[60] = CR_ALL & ~(CR_BLACK_SHORT | CR_BLACK_LONG);
+        masks[63] = CR_ALL & ~CR_BLACK_SHORT;
+
+        return masks;
+    }
+
+    constexpr std::array<uint8_t, 64> CASTLING_MASKS = CastlingMasks();
+
+    // FEN letters of the piece types, in PIECE_TYPE order (black; white ones are upper case).
+    const std::string PIECE_CHARACTERS = "prnbqk";
+
+    // The castling rights in bit order, as FEN writes them.
+    const struct {
+        char symbol;
+        PIECE_COLOR color;
+        int kingSquare;
+        int rookSquare;
+    } CASTLING_RIGHTS[4] = {
+        {'K', PIECE_COLOR::C_WHITE, 4, 7},
+        {'Q', PIECE_COLOR::C_WHITE, 4, 0},
+        {'k', PIECE_COLOR::C_BLACK, 60, 63},
+        {'q', PIECE_COLOR::C_BLACK, 60, 56}
+    };
+}
+
+void BoardState::Clear() {
+    *this = BoardState();
+    sideToMove = PIECE_COLOR::C_WHITE;
+    enPassantSquare = -1;
+    key = ComputeKey();
+}
+
+bool BoardState::LoadFen(const std::string& fen) {
+    Clear();
+
+    std::istringstream fields(fen);
+    std::string placement, side, castling = "-", enPassant = "-";
+    int halfmoves = 0;
+
+    if (!(fields >> placement >> side)) {
+        return false;
+    }
+
+    fields >> castling >> enPassant >> halfmoves;
+
+    // Placement runs from rank 8 down to rank 1, each rank from file a.
+    int rank = 7;
+    int file = 0;
+
+    for (char character : placement) {
+        if (character == '/') {
+            rank--;
+            file = 0;
+        } else if (character >= '1' && character <= '8') {
+            file += character - '0';
+        } else {
+            size_t type = PIECE_CHARACTERS.find(char(std::tolower(character)));
+
+            if (type == std::string::npos || rank < 0 || file > 7) {
+                Clear();
+                return false;
+            }
+
+            PIECE_COLOR color = std::isupper(character) ? PIECE_COLOR::C_WHITE : PIECE_COLOR::C_BLACK;
+            PutPiece(PIECE_TYPE(type), color, rank * 8 + file);
+            file++;
+        }
+    }
+
+    if (side != "w" && side != "b") {
+        Clear();
+        return false;
+    }
+
+    sideToMove = side == "w" ? PIECE_COLOR::C_WHITE : PIECE_COLOR::C_BLACK;
+
+    // Search needs one king a side, pawns that can still move and a side that just moved out of
+    // check; anything else could end with a king being captured.
+    Bitboard pawns = GetPieces(PIECE_COLOR::C_WHITE, PIECE_TYPE::PEON) | GetPieces(PIECE_COLOR::C_BLACK, PIECE_TYPE::PEON);
+
+    if (Bitboards::PopCount(GetPieces(PIECE_COLOR::C_WHITE, PIECE_TYPE::KING)) != 1 ||
+        Bitboards::PopCount(GetPieces(PIECE_COLOR::C_BLACK, PIECE_TYPE::KING)) != 1 ||
+        (pawns & (Bitboards::RANK_1 | Bitboards::RANK_8)) ||
+        IsInCheck(Opponent(sideToMove))
+    ) {
+        Clear();
+        return false;
+    }
+
+    // A right is only taken over if its king and rook are still in place.
+    int rights = 0;
+
+    for (int bit = 0; bit < 4; bit++) {
+        const auto& right = CASTLING_RIGHTS[bit];
+
+        if (castling.find(right.symbol) != std::string::npos &&
+            (GetPieces(right.color, PIECE_TYPE::KING) & Bitboards::SquareBit(right.kingSquare)) &&
+            (GetPieces(right.color, PIECE_TYPE::ROOK) & Bitboards::SquareBit(right.rookSquare))
+        ) {
+            rights |= 1 << bit;
+        }
+    }
+
+    SetCastlingRights(rights);
+
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && (enPassant[1] == '3' || enPassant[1] == '6')) {
+        int square = (enPassant[1] - '1') * 8 + (enPassant[0] - 'a');
+        // The pawn that walked over the en passant square stands one square beyond it.
+        int pawnSquare = sideToMove == PIECE_COLOR::C_WHITE ? square - 8 : square + 8;
+
+        if ((GetPieces(Opponent(sideToMove), PIECE_TYPE::PEON) & Bitboards::SquareBit(pawnSquare)) &&
+            (Bitboards::PawnAttacks(Opponent(sideToMove), square) & GetPieces(sideToMove, PIECE_TYPE::PEON))
+        ) {
+            enPassantSquare = int8_t(square);
+        }
+    }
+
+    halfmoveClock = uint8_t(std::min(std::max(halfmoves, 0), 255));
+    key = ComputeKey();
+
+    return true;
+}
+
+std::string BoardState::GetFen(int fullmoveNumber) const {
+    std::string fen;
+
+    for (int rank = 7; rank >= 0; rank--) {
+        int emptySquares = 0;
+
+        for (int file = 0; file < 8; file++) {
+            int square = rank * 8 + file;
+
+            if (IsEmpty(square)) {
+                emptySquares++;
+                continue;
+            }
+
+            if (emptySquares > 0) {
+                fen += char('0' + emptySquares);
+                emptySquares = 0;
+            }
+
+            char character = PIECE_CHARACTERS[TypeAt(square)];
+            fen += ColorAt(square) == PIECE_COLOR::C_WHITE ? char(std::toupper(character)) : character;
+        }
+
+        if (emptySquares > 0) {
+            fen += char('0' + emptySquares);
+        }
+
+        fen += rank > 0 ? '/' : ' ';
+    }
+
+    fen += sideToMove == PIECE_COLOR::C_WHITE ? "w " : "b ";
+
+    for (int bit = 0; bit < 4; bit++) {
+        if (castlingRights & (1 << bit)) {
+            fen += CASTLING_RIGHTS[bit].symbol;
+        }
+    }
+
+    if (castlingRights == 0) {
+        fen += '-';
+    }
+
+    if (enPassantSquare >= 0) {
+        fen += ' ';
+        fen += char('a' + enPassantSquare % 8);
+        fen += char('1' + enPassantSquare / 8);
+    } else {
+        fen += " -";
+    }
+
+    return fen + " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+}
+
+void BoardState::PutPiece(PIECE_TYPE type, PIECE_COLOR color, int square) {
+    Bitboard bit = Bitboards::SquareBit(square);
+
+    typeSets[type] |= bit;
+    colorSets[color] |= bit;
+    SetPieceCode(square, (type + 1) | (color << 3));
+    key ^= Zobrist::KEYS.pieces[color][type][square];
+    attackMapsValid = 0;
+}
+
+void BoardState::RemovePiece(int square) {
+    Bitboard bit = Bitboards::SquareBit(square);
+
+    typeSets[TypeAt(square)] &= ~bit;
+    colorSets[ColorAt(square)] &= ~bit;
+    key ^= Zobrist::KEYS.pieces[ColorAt(square)][TypeAt(square)][square];
+    SetPieceCode(square, 0);
+    attackMapsValid = 0;
+}
+
+void BoardState::MovePiece(int from, int to) {
+    int code = PieceCode(from);
+    PIECE_TYPE type = TypeAt(from);
+    PIECE_COLOR color = ColorAt(from);
+    Bitboard fromTo = Bitboards::SquareBit(from) | Bitboards::SquareBit(to);
+
+    typeSets[type] ^= fromTo;
+    colorSets[color] ^= fromTo;
+    key ^= Zobrist::KEYS.pieces[color][type][from] ^ Zobrist::KEYS.pieces[color][type][to];
+    SetPieceCode(from, 0);
+    SetPieceCode(to, code);
+    attackMapsValid = 0;
+}
+
+void BoardState::SetCastlingRights(int rights) {
+    key ^= Zobrist::KEYS.castling[castlingRights] ^ Zobrist::KEYS.castling[rights];
+    castlingRights = uint8_t(rights);
+}
+
+uint64_t BoardState::ComputeKey() const {
+    uint64_t key = 0;
+
+    for (int color = PIECE_COLOR::C_WHITE; color <= PIECE_COLOR::C_BLACK; color++) {
+        for (int type = PIECE_TYPE::PEON; type <= PIECE_TYPE::KING; type++) {
+            Bitboard pieces = GetPieces(PIECE_COLOR(color), PIECE_TYPE(type));
+
+            while (pieces) {
+                key ^= Zobrist::KEYS.pieces[color][type][Bitboards::PopLowestSquare(pieces)];
+            }
+        }
+    }
+
+    key ^= Zobrist::KEYS.castling[castlingRights];
+
+    if (enPassantSquare >= 0) {
+        key ^= Zobrist::KEYS.enPassantFile[enPassantSquare & 7];
+    }
+
+    if (sideToMove == PIECE_COLOR::C_BLACK) {
+        key ^= Zobrist::KEYS.blackToMove;
+    }
+
+    return key;
+}
+
+void BoardState::MakeMove(PackedMove move) {
+    int from = move.From();
+    int to = move.To();
+    MOVE_FLAG flag = move.Flag();
+    PIECE_COLOR us = sideToMove;
+
+    if (TypeAt(from) == PIECE_TYPE::PEON || move.IsCapture()) {
+        halfmoveClock = 0;
+    } else if (halfmoveClock < 255) {
+        halfmoveClock++;
+    }
+
+    // Take the captured piece off the board; en passant takes the pawn beside the moving one.
+    if (flag == F_EN_PASSANT) {
+        RemovePiece((from & ~7) | (to & 7));
+    } else if (move.IsCapture()) {
+        RemovePiece(to);
+    }
+
+    // In case of castling, the rook lands on the square the king passed over.
+    if (flag == F_SHORT_CASTLING) {
+        MovePiece(from + 3, from + 1);
+    } else if (flag == F_LONG_CASTLING) {
+        MovePiece(from - 4, from - 1);
+    }
+
+    MovePiece(from, to);
+
+    if (move.IsPromotion()) {
+        RemovePiece(to);
+        PutPiece(move.PromotionType(), us, to);
+    }
+
+    SetCastlingRights(castlingRights & CASTLING_MASKS[from] & CASTLING_MASKS[to]);
+    sideToMove = Opponent(us);
+    key ^= Zobrist::KEYS.blackToMove;
+
+    if (enPassantSquare >= 0) {
+        key ^= Zobrist::KEYS.enPassantFile[enPassantSquare & 7];
+        enPassantSquare = -1;
+    }
+
+    // Only kept when a pawn can actually take, so positions that play the same compare equal.
+    if (flag == F_DOUBLE_WALK) {
+        int skipped = (from + to) / 2;
+
+        if (Bitboards::PawnAttacks(us, skipped) & GetPieces(sideToMove, PIECE_TYPE::PEON)) {
+            enPassantSquare = int8_t(skipped);
+            key ^= Zobrist::KEYS.enPassantFile[skipped & 7];
+        }
+    }
+
+    CheckKey();
+}
+
+void BoardState::CheckKey() const {
+#if defined(RAY_CHESS_DEBUG_KEYS)
+    if (key != ComputeKey()) {
+        std::fprintf(stderr, "Zobrist key %016llx differs from recomputed %016llx\n",
+                     (unsigned long long) key, (unsigned long long) ComputeKey());
+        std::abort();
+    }
+#endif
+}
+
+bool BoardState::IsInCheck(PIECE_COLOR color) const {
+    return (GetPieces(color, PIECE_TYPE::KING) & GetAttackedSquares(Opponent(color))) != 0;
+}
+
+bool BoardState::IsInsufficientMaterial() const {
+    if (typeSets[PIECE_TYPE::PEON] | typeSets[PIECE_TYPE::ROOK] | typeSets[PIECE_TYPE::QUEEN]) {
+        return false;
+    }
+
+    Bitboard knights = typeSets[PIECE_TYPE::KNIGHT];
+    Bitboard bishops = typeSets[PIECE_TYPE::BISHOP];
+
+    if (Bitboards::PopCount(knights | bishops) <= 1) {
+        return true;
+    }
+
+    return !knights && (!(bishops & Bitboards::DARK_SQUARES) || !(bishops & ~Bitboards::DARK_SQUARES));
+}
+
+Bitboard BoardState::GetAttackedSquares(PIECE_COLOR byColor) const {
+    if (!(attackMapsValid & (1 << byColor))) {
+        attackMaps[byColor] = ComputeAttackedSquares(byColor);
+        attackMapsValid |= 1 << byColor;
+    }
+
+    return attackMaps[byColor];
+}
+
+int BoardState::GetMobility(PIECE_COLOR color) const {
+    return Bitboards::PopCount(GetAttackedSquares(color) & ~GetPieces(color));
+}
+
+bool BoardState::IsSquareAttacked(int square, PIECE_COLOR byColor) const {
+    return (GetAttackedSquares(byColor) & Bitboards::SquareBit(square)) != 0;
+}
+
+bool BoardState::IsSquareAttacked(int square, PIECE_COLOR byColor, Bitboard occupied) const {
+    return AttackersOf(square, byColor, occupied) != 0;
+}
+
+namespace {
+    // Union of the attacks of a set of pieces of one type.
+    template <PIECE_TYPE PieceType>
+    Bitboard AttacksOfSet(Bitboard pieces, Bitboard occupied) {
+        Bitboard attacks = 0;
+
+        while (pieces) {
+            attacks |= Bitboards::Attacks<PieceType>(Bitboards::PopLowestSquare(pieces), occupied);
+        }
+
+        return attacks;
+    }
+}
+
+Bitboard BoardState::ComputeAttackedSquares(PIECE_COLOR byColor) const {
+    Bitboard occupied = GetOccupied();
+    Bitboard pawns = GetPieces(byColor, PIECE_TYPE::PEON);
+    Bitboard attacks;
+
+    // All pawns at once, towards the a-file and towards the h-file.
+    if (byColor == PIECE_COLOR::C_WHITE) {
+        attacks = Bitboards::Shift<7>(pawns & ~Bitboards::FILE_A) | Bitboards::Shift<9>(pawns & ~Bitboards::FILE_H);
+    } else {
+        attacks = Bitboards::Shift<-9>(pawns & ~Bitboards::FILE_A) | Bitboards::Shift<-7>(pawns & ~Bitboards::FILE_H);
+    }
+
+    Bitboard queens = GetPieces(byColor, PIECE_TYPE::QUEEN);
+
+    attacks |= AttacksOfSet<PIECE_TYPE::KNIGHT>(GetPieces(byColor, PIECE_TYPE::KNIGHT), occupied);
+    attacks |= AttacksOfSet<PIECE_TYPE::BISHOP>(GetPieces(byColor, PIECE_TYPE::BISHOP) | queens, occupied);
+    attacks |= AttacksOfSet<PIECE_TYPE::ROOK>(GetPieces(byColor, PIECE_TYPE::ROOK) | queens, occupied);
+    attacks |= AttacksOfSet<PIECE_TYPE::KING>(GetPieces(byColor, PIECE_TYPE::KING), occupied);
+
+    return attacks;
+}
+
+Bitboard BoardState::AttackersOf(int square, PIECE_COLOR byColor, Bitboard occupied) const {
+    Bitboard queens = GetPieces(byColor, PIECE_TYPE::QUEEN);
+
+    // A piece attacks the square exactly when it stands on a square the same kind of piece
+    // would attack from the target square (pawns use the opposite color).
+    return (Bitboards::PawnAttacks(Opponent(byColor), square) & GetPieces(byColor, PIECE_TYPE::PEON)) |
+           (Bitboards::KnightAttacks(square) & GetPieces(byColor, PIECE_TYPE::KNIGHT)) |
+           (Bitboards::KingAttacks(square) & GetPieces(byColor, PIECE_TYPE::KING)) |
+           (Bitboards::BishopAttacks(square, occupied) & (GetPieces(byColor, PIECE_TYPE::BISHOP) | queens)) |
+           (Bitboards::RookAttacks(square, occupied) & (GetPieces(byColor, PIECE_TYPE::ROOK) | queens));
+}
+
+void BoardState::GetLegalMoves(PIECE_COLOR color, MoveList& moves, GENERATION_TYPE type) const {
+    CheckInfo checkInfo = GetCheckInfo(color);
+    int first = moves.Size();
+
+    GenerateMoves(color, type, moves, ~GetPieces(color) & checkInfo.evasionTargets);
+
+    // Other moves already block or capture the checker, so only king moves, en passant and
+    // moves of pinned pieces can still leave the king in check.
+    Bitboard needsCheck = checkInfo.pinned | Bitboards::SquareBit(checkInfo.kingSquare);
+
+    for (int index = first; index < moves.Size();) {
+        PackedMove move = moves[index];
+
+        if (((needsCheck & Bitboards::SquareBit(move.From())) || move.Flag() == F_EN_PASSANT) && !IsLegal(move, checkInfo)) {
+            moves.RemoveAt(index);
+        } else {
+            index++;
+        }
+    }
+}
+
+void BoardState::GetPseudoLegalMoves(PIECE_COLOR color, MoveList& moves, GENERATION_TYPE type) const {
+    Bitboard targets = ~GetPieces(color);
+
+    if (type == G_EVASIONS) {
+        targets &= GetCheckInfo(color).evasionTargets;
+    }
+
+    GenerateMoves(color, type, moves, targets);
+}
+
+bool BoardState::IsLegalMove(PIECE_COLOR color, PackedMove move) const {
+    return IsPseudoLegal(color, move) && IsLegal(move, GetCheckInfo(color));
+}
+
+bool BoardState::IsPseudoLegal(PIECE_COLOR color, PackedMove move) const {
+    int from = move.From();
+    int to = move.To();
+    MOVE_FLAG flag = move.Flag();
+
+    if (move.IsNone() || IsEmpty(from) || ColorAt(from) != color) {
+        return false;
+    }
+
+    PIECE_TYPE type = TypeAt(from);
+
+    Bitboard toBit = Bitboards::SquareBit(to);
+    Bitboard occupied = GetOccupied();
+    Bitboard enemies = GetPieces(Opponent(color));
+
+    if (type == PIECE_TYPE::PEON) {
+        if (flag == F_EN_PASSANT) {
+            return to == GetEnPassantSquare(color) && (Bitboards::PawnAttacks(color, from) & toBit);
+        }
+
+        if (flag == F_SHORT_CASTLING || flag == F_LONG_CASTLING) {
+            return false;
+        }
+
+        // Pawns promote exactly when they reach the last rank.
+        Bitboard promotionRank = color == PIECE_COLOR::C_WHITE ? Bitboards::RANK_8 : Bitboards::RANK_1;
+
+        if (bool(promotionRank & toBit) != move.IsPromotion()) {
+            return false;
+        }
+
+        if (move.IsCapture()) {
+            return Bitboards::PawnAttacks(color, from) & enemies & toBit;
+        }
+
+        int up = color == PIECE_COLOR::C_WHITE ? 8 : -8;
+
+        if (flag == F_DOUBLE_WALK) {
+            Bitboard startRank = color == PIECE_COLOR::C_WHITE ? Bitboards::RANK_1 << 8 : Bitboards::RANK_8 >> 8;
+
+            return (startRank & Bitboards::SquareBit(from)) && to == from + 2 * up &&
+                   !(occupied & (Bitboards::SquareBit(from + up) | toBit));
+        }
+
+        return to == from + up && !(occupied & toBit);
+    }
+
+    if (flag == F_SHORT_CASTLING || flag == F_LONG_CASTLING) {
+        MoveList castlingMoves;
+
+        if (color == PIECE_COLOR::C_WHITE) {
+            GenerateCastlingMoves<PIECE_COLOR::C_WHITE>(castlingMoves);
+        } else {
+            GenerateCastlingMoves<PIECE_COLOR::C_BLACK>(castlingMoves);
+        }
+
+        for (PackedMove castlingMove : castlingMoves) {
+            if (castlingMove == move) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Everything else is a plain walk onto an empty square or an attack on an enemy.
+    if ((flag != F_WALK && flag != F_ATTACK) || bool(enemies & toBit) != (flag == F_ATTACK)) {
+        return false;
+    }
+
+    Bitboard attacks;
+
+    switch (type) {
+        case KNIGHT:
+            attacks = Bitboards::Attacks<PIECE_TYPE::KNIGHT>(from, occupied);
+            break;
+        case BISHOP:
+            attacks = Bitboards::Attacks<PIECE_TYPE::BISHOP>(from, occupied);
+            break;
+        case ROOK:
+            attacks = Bitboards::Attacks<PIECE_TYPE::ROOK>(from, occupied);
+            break;
+        case QUEEN:
+            attacks = Bitboards::Attacks<PIECE_TYPE::QUEEN>(from, occupied);
+            break;
+        default:
+            attacks = Bitboards::Attacks<PIECE_TYPE::KING>(from, occupied);
+            break;
+    }
+
+    return attacks & ~GetPieces(color) & toBit;
+}
+
+namespace {
+    // Adds a move onto every target square, from the square offset squares behind it.
+    void AddMovesFromOffset(MoveList& moves, Bitboard targets, int offset, MOVE_FLAG flag) {
+        while (targets) {
+            int to = Bitboards::PopLowestSquare(targets);
+            moves.Add({to - offset, to, flag});
+        }
+    }
+
+    // Adds the four promotions onto every target square, queen first, from the square offset
+    // squares behind it. The flags of one kind of promotion run rook, knight, bishop, queen.
+    void AddPromotionsFromOffset(MoveList& moves, Bitboard targets, int offset, MOVE_FLAG queenFlag) {
+        while (targets) {
+            int to = Bitboards::PopLowestSquare(targets);
+
+            for (int flag = queenFlag; flag > queenFlag - 4; flag--) {
+                moves.Add({to - offset, to, MOVE_FLAG(flag)});
+            }
+        }
+    }
+
+    // Adds a walk or an attack from one square to every target, depending on whether it holds an enemy.
+    void AddMovesFromSquare(MoveList& moves, int from, Bitboard targets, Bitboard enemies) {
+        while (targets) {
+            int to = Bitboards::PopLowestSquare(targets);
+            moves.Add({from, to, (enemies & Bitboards::SquareBit(to)) ? F_ATTACK : F_WALK});
+        }
+    }
+}
+
+void BoardState::GenerateMoves(PIECE_COLOR color, GENERATION_TYPE type, MoveList& moves, Bitboard targets) const {
+    bool isWhite = color == PIECE_COLOR::C_WHITE;
+
+    switch (type) {
+        case G_CAPTURES:
+            isWhite ? GenerateMoves<PIECE_COLOR::C_WHITE, G_CAPTURES>(moves, targets)
+                    : GenerateMoves<PIECE_COLOR::C_BLACK, G_CAPTURES>(moves, targets);
+            break;
+        case G_QUIETS:
+            isWhite ? GenerateMoves<PIECE_COLOR::C_WHITE, G_QUIETS>(moves, targets)
+                    : GenerateMoves<PIECE_COLOR::C_BLACK, G_QUIETS>(moves, targets);
+            break;
+        case G_EVASIONS:
+            isWhite ? GenerateMoves<PIECE_COLOR::C_WHITE, G_EVASIONS>(moves, targets)
+                    : GenerateMoves<PIECE_COLOR::C_BLACK, G_EVASIONS>(moves, targets);
+            break;
+        default:
+            isWhite ? GenerateMoves<PIECE_COLOR::C_WHITE, G_ALL>(moves, targets)
+                    : GenerateMoves<PIECE_COLOR::C_BLACK, G_ALL>(moves, targets);
+            break;
+    }
+}
+
+template <PIECE_COLOR Us, GENERATION_TYPE Type>
+void BoardState::GenerateMoves(MoveList& moves, Bitboard targets) const {
+    constexpr PIECE_COLOR Them = Us == PIECE_COLOR::C_WHITE ? PIECE_COLOR::C_BLACK : PIECE_COLOR::C_WHITE;
+
+    // Pieces other than pawns capture where they move, so the kind of move is just the target square.
+    Bitboard pieceTargets = Type == G_CAPTURES ? GetPieces(Them) : Type == G_QUIETS ? ~GetOccupied() : ~GetPieces(Us);
+
+    GeneratePieceMoves<PIECE_TYPE::KING>(Us, moves, pieceTargets);
+
+    // In double check there is nothing to block or capture, only the king can move.
+    if (Type == G_EVASIONS && !targets) {
+        return;
+    }
+
+    GeneratePawnMoves<Us, Type>(moves, targets);
+    GeneratePieceMoves<PIECE_TYPE::KNIGHT>(Us, moves, targets & pieceTargets);
+    GeneratePieceMoves<PIECE_TYPE::BISHOP>(Us, moves, targets & pieceTargets);
+    GeneratePieceMoves<PIECE_TYPE::ROOK>(Us, moves, targets & pieceTargets);
+    GeneratePieceMoves<PIECE_TYPE::QUEEN>(Us, moves, targets & pieceTargets);
+
+    // Castling is a quiet move, and never allowed out of check.
+    if constexpr (Type == G_QUIETS || Type == G_ALL) {
+        GenerateCastlingMoves<Us>(moves);
+    }
+}
+
+template <PIECE_COLOR Us, GENERATION_TYPE Type>
+void BoardState::GeneratePawnMoves(MoveList& moves, Bitboard targets) const {
+    constexpr PIECE_COLOR Them = Us == PIECE_COLOR::C_WHITE ? PIECE_COLOR::C_BLACK : PIECE_COLOR::C_WHITE;
+    // White pawns walk up the board (towards rank 8), black ones down.
+    constexpr int Up = Us == PIECE_COLOR::C_WHITE ? 8 : -8;
+    constexpr Bitboard PromotionRank = Us == PIECE_COLOR::C_WHITE ? Bitboards::RANK_8 : Bitboards::RANK_1;
+    // Where a single walk from the starting rank lands.
+    constexpr Bitboard DoubleWalkRank = Us == PIECE_COLOR::C_WHITE ? Bitboards::RANK_1 << 16 : Bitboards::RANK_8 >> 16;
+
+    Bitboard pawns = GetPieces(Us, PIECE_TYPE::PEON);
+    Bitboard empty = ~GetOccupied();
+
+    Bitboard walks = Bitboards::Shift<Up>(pawns) & empty;
+
+    if constexpr (Type != G_QUIETS) {
+        Bitboard enemies = GetPieces(Them) & targets;
+
+        // Attacks towards the a-file and towards the h-file.
+        Bitboard westAttacks = Bitboards::Shift<Up - 1>(pawns & ~Bitboards::FILE_A) & enemies;
+        Bitboard eastAttacks = Bitboards::Shift<Up + 1>(pawns & ~Bitboards::FILE_H) & enemies;
+
+        AddMovesFromOffset(moves, westAttacks & ~PromotionRank, Up - 1, F_ATTACK);
+        AddMovesFromOffset(moves, eastAttacks & ~PromotionRank, Up + 1, F_ATTACK);
+
+        AddPromotionsFromOffset(moves, walks & targets & PromotionRank, Up, F_PROMOTION_QUEEN);
+        AddPromotionsFromOffset(moves, westAttacks & PromotionRank, Up - 1, F_ATTACK_AND_PROMOTION_QUEEN);
+        AddPromotionsFromOffset(moves, eastAttacks & PromotionRank, Up + 1, F_ATTACK_AND_PROMOTION_QUEEN);
+
+        int enPassantSquare = GetEnPassantSquare(Us);
+
+        // Out of check, en passant has to take the checking pawn or land in the checking line.
+        if (Type == G_EVASIONS && enPassantSquare >= 0 &&
+            !(targets & (Bitboards::SquareBit(enPassantSquare) | Bitboards::SquareBit(enPassantSquare - Up)))
+        ) {
+            enPassantSquare = -1;
+        }
+
+        if (enPassantSquare >= 0) {
+            Bitboard attackers = Bitboards::PawnAttacks(Them, enPassantSquare) & pawns;
+
+            while (attackers) {
+                moves.Add({Bitboards::PopLowestSquare(attackers), enPassantSquare, F_EN_PASSANT});
+            }
+        }
+    }
+
+    if constexpr (Type != G_CAPTURES) {
+        Bitboard doubleWalks = Bitboards::Shift<Up>(walks & DoubleWalkRank) & empty & targets;
+
+        AddMovesFromOffset(moves, walks & targets & ~PromotionRank, Up, F_WALK);
+        AddMovesFromOffset(moves, doubleWalks, 2 * Up, F_DOUBLE_WALK);
+    }
+}
+
+template <PIECE_TYPE PieceType>
+void BoardState::GeneratePieceMoves(PIECE_COLOR color, MoveList& moves, Bitboard targets) const {
+    Bitboard pieces = GetPieces(color, PieceType);
+    Bitboard occupied = GetOccupied();
+    Bitboard enemies = GetPieces(Opponent(color));
+
+    while (pieces) {
+        int from = Bitboards::PopLowestSquare(pieces);
+        AddMovesFromSquare(moves, from, Bitboards::Attacks<PieceType>(from, occupied) & targets, enemies);
+    }
+}
+
+template <PIECE_COLOR Us>
+void BoardState::GenerateCastlingMoves(MoveList& moves) const {
+    // A right is only kept while its king and rook have not moved, so they are on e1 or e8
+    // and in the corner.
+    constexpr int KingSquare = Us == PIECE_COLOR::C_WHITE ? 4 : 60;
+    constexpr int ShortRight = Us == PIECE_COLOR::C_WHITE ? CR_WHITE_SHORT : CR_BLACK_SHORT;
+    constexpr int LongRight = Us == PIECE_COLOR::C_WHITE ? CR_WHITE_LONG : CR_BLACK_LONG;
+
+    Bitboard occupied = GetOccupied();
+
+    if ((castlingRights & ShortRight) && !(Bitboards::Between(KingSquare, KingSquare + 3) & occupied)) {
+        moves.Add({KingSquare, KingSquare + 2, F_SHORT_CASTLING});
+    }
+
+    if ((castlingRights & LongRight) && !(Bitboards::Between(KingSquare, KingSquare - 4) & occupied)) {
+        moves.Add({KingSquare, KingSquare - 2, F_LONG_CASTLING});
+    }
+}
+
+int BoardState::GetEnPassantSquare(PIECE_COLOR color) const {
+    return color == sideToMove ? enPassantSquare : -1;
+}
+
+BoardState::CheckInfo BoardState::GetCheckInfo(PIECE_COLOR color) const {
+    PIECE_COLOR enemyColor = Opponent(color);
+    Bitboard occupied = GetOccupied();
+
+    CheckInfo checkInfo;
+    checkInfo.kingSquare = Bitboards::LowestSquare(GetPieces(color, PIECE_TYPE::KING));
+    checkInfo.checkers = AttackersOf(checkInfo.kingSquare, enemyColor, occupied);
+    checkInfo.pinned = 0;
+
+    // Enemy sliders that would hit the king on an empty board pin a piece if exactly
+    // one piece, ours, stands between them.
+    Bitboard enemyQueens = GetPieces(enemyColor, PIECE_TYPE::QUEEN);
+    Bitboard snipers = (Bitboards::RookAttacks(checkInfo.kingSquare, 0) & (GetPieces(enemyColor, PIECE_TYPE::ROOK) | enemyQueens)) |
+                       (Bitboards::BishopAttacks(checkInfo.kingSquare, 0) & (GetPieces(enemyColor, PIECE_TYPE::BISHOP) | enemyQueens));
+
+    while (snipers) {
+        Bitboard blockers = Bitboards::Between(checkInfo.kingSquare, Bitboards::PopLowestSquare(snipers)) & occupied;
+
+        if (Bitboards::PopCount(blockers) == 1) {
+            checkInfo.pinned |= blockers & GetPieces(color);
+        }
+    }
+
+    if (checkInfo.checkers == 0) {
+        checkInfo.evasionTargets = ~Bitboard(0);
+    } else if (Bitboards::PopCount(checkInfo.checkers) == 1) {
+        checkInfo.evasionTargets = checkInfo.checkers | Bitboards::Between(checkInfo.kingSquare, Bitboards::LowestSquare(checkInfo.checkers));
+    } else {
+        checkInfo.evasionTargets = 0;
+    }
+
+    return checkInfo;
+}
+
+bool BoardState::IsLegal(PackedMove move, const CheckInfo& checkInfo) const {
+    int from = move.From();
+    int to = move.To();
+    MOVE_FLAG flag = move.Flag();
+
+    PIECE_COLOR enemyColor = Opponent(ColorAt(from));
+    Bitboard occupied = GetOccupied();
+
+    if (TypeAt(from) == PIECE_TYPE::KING) {
+        // Castling is not allowed out of check, nor through or into an attacked square.
+        if (flag == F_SHORT_CASTLING || flag == F_LONG_CASTLING) {
+            int step = flag == F_SHORT_CASTLING ? 1 : -1;
+
+            return checkInfo.checkers == 0 &&
+                   !AttackersOf(from + step, enemyColor, occupied) &&
+                   !AttackersOf(from + 2 * step, enemyColor, occupied);
+        }
+
+        // The king must not be able to hide behind itself from a slider, so it is lifted off the board.
+        return !AttackersOf(to, enemyColor, occupied ^ Bitboards::SquareBit(from));
+    }
+
+    // En passant removes two pieces from one rank, which can expose the king in ways pins do
+    // not describe, so it is checked directly on the resulting occupancy.
+    if (flag == F_EN_PASSANT) {
+        // The captured pawn stands beside the moving one, on the target file.
+        Bitboard capturedBit = Bitboards::SquareBit((from & ~7) | (to & 7));
+        Bitboard occupiedAfter = (occupied ^ Bitboards::SquareBit(from) ^ capturedBit) | Bitboards::SquareBit(to);
+
+        return !(AttackersOf(checkInfo.kingSquare, enemyColor, occupiedAfter) & ~capturedBit);
+    }
+
+    if (!(checkInfo.evasionTargets & Bitboards::SquareBit(to))) {
+        return false;
+    }
+
+    // A pinned piece may only move along the line through its king.
+    return !(checkInfo.pinned & Bitboards::SquareBit(from)) ||
+           (Bitboards::Line(checkInfo.kingSquare, from) & Bitboards::SquareBit(to));
+}
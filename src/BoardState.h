@@ -0,0 +1,185 @@
+#ifndef RAY_CHESS_BOARDSTATE_H
+#define RAY_CHESS_BOARDSTATE_H
+
+#include "Bitboard.h"
+#include "Move.h"
+#include "MoveList.h"
+#include "pieces/PieceEnums.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Which moves a generator produces. Captures include promotions, so quiet moves and captures
+// together are all moves. Evasions are for a side in check: king moves, captures of the
+// checker and moves into its line.
+enum GENERATION_TYPE {
+    G_CAPTURES,
+    G_QUIETS,
+    G_EVASIONS,
+    G_ALL
+};
+
+// Castling rights, one bit each.
+enum CASTLING_RIGHT {
+    CR_WHITE_SHORT = 1,
+    CR_WHITE_LONG = 2,
+    CR_BLACK_SHORT = 4,
+    CR_BLACK_LONG = 8,
+    CR_ALL = 15
+};
+
+// The whole position as the engine sees it: piece sets, a mailbox, side to move, castling
+// rights, en passant square, halfmove clock and Zobrist key. It holds no pointers and has no virtual
+// functions, so copying one is a single memcpy and search can play a move on a copy of the
+// parent (copy-make) instead of making and unmaking it.
+//
+// Move generation and legality live here and only ever look at these fields.
+struct BoardState {
+    // Empty board, white to move, no rights.
+    void Clear();
+    // Sets up the position of a FEN string. Returns false (leaving the state empty) if the
+    // string cannot be read or the position cannot be played from: a side without exactly one
+    // king, a pawn on the first or last rank, or the side not to move in check.
+    bool LoadFen(const std::string& fen);
+    // The position as a FEN string. The state does not count moves, so the caller passes the
+    // move number.
+    std::string GetFen(int fullmoveNumber = 1) const;
+
+    void PutPiece(PIECE_TYPE type, PIECE_COLOR color, int square);
+    void RemovePiece(int square);
+
+    bool IsEmpty(int square) const {
+        return PieceCode(square) == 0;
+    }
+
+    // Only meaningful for squares holding a piece.
+    PIECE_TYPE TypeAt(int square) const {
+        return PIECE_TYPE((PieceCode(square) & 7) - 1);
+    }
+
+    PIECE_COLOR ColorAt(int square) const {
+        return PIECE_COLOR(PieceCode(square) >> 3);
+    }
+
+    Bitboard GetPieces(PIECE_COLOR color, PIECE_TYPE type) const {
+        return typeSets[type] & colorSets[color];
+    }
+
+    Bitboard GetPieces(PIECE_COLOR color) const {
+        return colorSets[color];
+    }
+
+    Bitboard GetOccupied() const {
+        return colorSets[PIECE_COLOR::C_WHITE] | colorSets[PIECE_COLOR::C_BLACK];
+    }
+
+    // Replaces the castling rights, keeping the key up to date.
+    void SetCastlingRights(int rights);
+
+    // Zobrist key of the position (pieces, side to move, castling rights and en passant file),
+    // worked out from scratch. The key field holds the same value, kept up to date by every
+    // change to the state.
+    uint64_t ComputeKey() const;
+
+    // Plays a move of the side to move, promoting to the piece the move names, and passes
+    // the turn. The move must be pseudo-legal.
+    void MakeMove(PackedMove move);
+
+    bool IsInCheck(PIECE_COLOR color) const;
+    // Whether neither side has the pieces left to ever checkmate: kings with at most one minor
+    // piece, or with bishops that all stand on squares of one color.
+    bool IsInsufficientMaterial() const;
+    // Every square a color attacks. Worked out on first use after a change to the pieces and
+    // cached until the next one, so repeated check, attack and mobility queries are single loads.
+    Bitboard GetAttackedSquares(PIECE_COLOR byColor) const;
+    // Squares a color attacks that are not taken by its own pieces.
+    int GetMobility(PIECE_COLOR color) const;
+    bool IsSquareAttacked(int square, PIECE_COLOR byColor) const;
+    // Whether the square is attacked when sliders look through the given occupancy instead of the board's.
+    bool IsSquareAttacked(int square, PIECE_COLOR byColor, Bitboard occupied) const;
+
+    // All legal moves of one side. Checkers and pins are computed once for the whole position,
+    // so no move has to be played to find out whether it leaves the king in check. The moves
+    // are appended to the list.
+    void GetLegalMoves(PIECE_COLOR color, MoveList& moves, GENERATION_TYPE type = G_ALL) const;
+    // All moves of one side that follow the piece rules, including ones that leave the king in check.
+    void GetPseudoLegalMoves(PIECE_COLOR color, MoveList& moves, GENERATION_TYPE type = G_ALL) const;
+    // Whether a move, e.g. one remembered from another position, can be played here. Much
+    // cheaper than generating all moves and looking for it.
+    bool IsLegalMove(PIECE_COLOR color, PackedMove move) const;
+
+    // One set per piece type and one per color; a piece of a given type and color is their intersection.
+    Bitboard typeSets[6];
+    Bitboard colorSets[2];
+
+    uint64_t key;
+
+    // Cache behind GetAttackedSquares, one map per color. Bit c of attackMapsValid is set
+    // while the map of color c is current.
+    mutable Bitboard attackMaps[2];
+
+    // Piece on each square, two squares to a byte: 0 for an empty square, else the piece
+    // type plus one, with the color in the fourth bit.
+    uint8_t mailbox[32];
+
+    PIECE_COLOR sideToMove;
+    // CASTLING_RIGHT bits.
+    uint8_t castlingRights;
+    // Square a pawn of the side to move can capture onto en passant, or -1.
+    int8_t enPassantSquare;
+    // Plies since the last capture or pawn move (saturating).
+    uint8_t halfmoveClock;
+    mutable uint8_t attackMapsValid;
+
+private:
+    // What legal move generation needs to know about one side's king.
+    struct CheckInfo {
+        int kingSquare;
+        Bitboard checkers;
+        Bitboard pinned;
+        // Squares a non-king move must land on: everything when not in check, the checker and
+        // the squares between it and the king in single check, nothing in double check.
+        Bitboard evasionTargets;
+    };
+
+    int PieceCode(int square) const {
+        return (mailbox[square >> 1] >> ((square & 1) * 4)) & 15;
+    }
+
+    void SetPieceCode(int square, int code) {
+        int shift = (square & 1) * 4;
+        mailbox[square >> 1] = uint8_t((mailbox[square >> 1] & ~(15 << shift)) | (code << shift));
+    }
+
+    void MovePiece(int from, int to);
+    // With RAY_CHESS_DEBUG_KEYS, stops the program if the key differs from one computed from scratch.
+    void CheckKey() const;
+
+    // Move generation, compiled separately for each side and piece type so every loop is a
+    // straight run over one piece set. Only moves onto targets are produced, except for king
+    // moves (any square not holding an own piece) and castling and en passant, which are left
+    // to IsLegal.
+    void GenerateMoves(PIECE_COLOR color, GENERATION_TYPE type, MoveList& moves, Bitboard targets) const;
+    template <PIECE_COLOR Us, GENERATION_TYPE Type>
+    void GenerateMoves(MoveList& moves, Bitboard targets) const;
+    template <PIECE_COLOR Us, GENERATION_TYPE Type>
+    void GeneratePawnMoves(MoveList& moves, Bitboard targets) const;
+    template <PIECE_TYPE PieceType>
+    void GeneratePieceMoves(PIECE_COLOR color, MoveList& moves, Bitboard targets) const;
+    template <PIECE_COLOR Us>
+    void GenerateCastlingMoves(MoveList& moves) const;
+    // Square a pawn of the given color could capture en passant onto, or -1.
+    int GetEnPassantSquare(PIECE_COLOR color) const;
+
+    CheckInfo GetCheckInfo(PIECE_COLOR color) const;
+    bool IsLegal(PackedMove move, const CheckInfo& checkInfo) const;
+    bool IsPseudoLegal(PIECE_COLOR color, PackedMove move) const;
+    Bitboard AttackersOf(int square, PIECE_COLOR byColor, Bitboard occupied) const;
+    Bitboard ComputeAttackedSquares(PIECE_COLOR byColor) const;
+};
+
+static_assert(std::is_trivially_copyable<BoardState>::value, "BoardState must be copyable with memcpy");
+static_assert(sizeof(BoardState) <= 128, "BoardState should fit in two cache lines");
+
+#endif //RAY_CHESS_BOARDSTATE_H
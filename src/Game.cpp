@@ -2,10 +2,6 @@
 #include "Position.h"
 #include "raylib.h"
 #include "Renderer.h"
-#include "pieces/Queen.h"
-#include "pieces/Knight.h"
-#include "pieces/Bishop.h"
-#include "pieces/Rook.h"
 
 #include <filesystem>
 #include <iostream>
@@ -26,7 +22,6 @@ Game::Game() {
     LoadTextures();
     LoadSounds();
     ai = new AI(PIECE_COLOR::C_BLACK);
-    aiThinkingTimer = 0.0f;
 
     // Init the board and calculate the initial movements for the white player.
     board.Init();
@@ -106,8 +101,10 @@ void Game::Run() {
         {
             std::vector<Move> movesOfSelectedPiece;
 
-            if (selectedPiece) {
-                movesOfSelectedPiece = possibleMovesPerPiece.at(selectedPiece);
+            auto selectedMoves = possibleMovesPerPiece.find(selectedPiece);
+
+            if (selectedMoves != possibleMovesPerPiece.end()) {
+                movesOfSelectedPiece = selectedMoves->second;
             }
 
             Renderer::ChangeMouseCursor(board, movesOfSelectedPiece, turn, state == GAME_STATE::S_PROMOTION);
@@ -126,11 +123,11 @@ void Game::Run() {
             }
             // Render promotion screen.
             if (state == GAME_STATE::S_PROMOTION) {
-                Renderer::RenderPromotionScreen(textures, selectedPiece->color);
+                Renderer::RenderPromotionScreen(textures, turn);
             }
 
             // Render end-game screen.
-            if (state == GAME_STATE::S_WHITE_WINS || state == GAME_STATE::S_BLACK_WINS) {
+            if (IsGameOver()) {
                 Renderer::RenderEndScreen(state);
             }
         }
@@ -160,13 +157,7 @@ void Game::HandleInput() {
                 PlaySound(sounds["clickCancel"]);
             }
 
-            // Piece must still be selected to render promotion screen.
-            if (!desiredMove ||
-               (desiredMove->type != MOVE_TYPE::PROMOTION &&
-                desiredMove->type != MOVE_TYPE::ATTACK_AND_PROMOTION)
-            ) {
-                selectedPiece = nullptr;
-            }
+            selectedPiece = nullptr;
         }
     }
 }
@@ -179,26 +170,23 @@ void Game::HandleInputPromotion() {
         Position clickedPosition = {int(mousePosition.y) / CELL_SIZE, int(mousePosition.x) / CELL_SIZE};
 
         if (clickedPosition.i == 3 && clickedPosition.j >= 2 && clickedPosition.j <= 5) {
-            Piece* newPiece;
+            PIECE_TYPE type;
 
             if (clickedPosition.j == 2) { // Clicked queen.
-                newPiece = new Queen(selectedPiece->GetPosition(), selectedPiece->color);
+                type = PIECE_TYPE::QUEEN;
             } else if (clickedPosition.j == 3) { // Clicked rook.
-                newPiece = new Rook(selectedPiece->GetPosition(), selectedPiece->color);
+                type = PIECE_TYPE::ROOK;
             } else if (clickedPosition.j == 4) { // Clicked bishop.
-                newPiece = new Bishop(selectedPiece->GetPosition(), selectedPiece->color);
+                type = PIECE_TYPE::BISHOP;
             } else { // Clicked knight.
-                newPiece = new Knight(selectedPiece->GetPosition(), selectedPiece->color);
+                type = PIECE_TYPE::KNIGHT;
             }
 
-            // Destroy peon, create new piece at same position.
-            board.Destroy(selectedPiece->GetPosition());
-            board.Add(newPiece);
+            // Swap the promoted pawn (a queen until now) for the chosen piece.
+            board.Promote(promotionPosition, type);
 
-            // Quit promotion, deselect peon and swap turns.
+            // Quit promotion and swap turns.
             state = GAME_STATE::S_RUNNING;
-
-            selectedPiece = nullptr;
             possibleMovesPerPiece.clear();
 
             SwapTurns();
@@ -225,6 +213,8 @@ void Game::DoMoveOnBoard(const Move& move) {
 
     // If the move was a promotion move, show the promotion screen. Else, swap turns.
     if (move.type == MOVE_TYPE::PROMOTION || move.type == MOVE_TYPE::ATTACK_AND_PROMOTION) {
+        // The pawn has become a queen, which stays until the player picks a piece.
+        promotionPosition = move.position;
         state = GAME_STATE::S_PROMOTION;
     } else {
         SwapTurns();
@@ -249,15 +239,22 @@ void Game::SwapTurns() {
 void Game::CalculateAllPossibleMovements() {
     possibleMovesPerPiece.clear();
 
+    // Every piece gets an entry, even without moves, so it can still be selected.
     for (Piece* piece : board.GetPiecesByColor(turn)) {
-        possibleMovesPerPiece[piece] = piece->GetPossibleMoves(board);
+        possibleMovesPerPiece[piece];
     }
 
-    // Remove the moves that could destroy the opponent's king.
-    FilterMovesThatAttackOppositeKing();
+    MoveList legalMoves;
+    board.GetLegalMoves(turn, legalMoves);
+
+    for (PackedMove move : legalMoves) {
+        // The piece a pawn promotes to is picked on the promotion screen, so one entry per target will do.
+        if (move.IsPromotion() && move.PromotionType() != PIECE_TYPE::QUEEN) {
+            continue;
+        }
 
-    // Remove the moves that cause the player to get in check.
-    FilterMovesThatLeadToCheck();
+        possibleMovesPerPiece[board.At(Bitboards::PositionOf(move.From()))].push_back(move.ToMove());
+    }
 }
 
 void Game::CheckForEndOfGame() {
@@ -272,55 +269,24 @@ void Game::CheckForEndOfGame() {
         // If not in check and there is not any move possible, declare stalemate.
         state = GAME_STATE::S_STALEMATE;
     }
-}
-
-void Game::FilterMovesThatAttackOppositeKing() {
-    for (auto& [piece, possibleMoves] : possibleMovesPerPiece) {
-        for (int i = possibleMoves.size() - 1; i >= 0; i--) {
-            Move& move = possibleMoves[i];
 
-            // Remove moves that attack the opponent's king.
-            bool isAttackMove = move.type == MOVE_TYPE::ATTACK || move.type == MOVE_TYPE::ATTACK_AND_PROMOTION;
-
-            if (isAttackMove) {
-                Piece* attackedPiece = board.At(move.position);
+    if (IsGameOver()) {
+        return;
+    }
 
-                if (attackedPiece->type == PIECE_TYPE::KING && attackedPiece->color != turn) {
-                    possibleMoves.erase(possibleMoves.begin() + i);
-                }
-            }
-        }
+    // Draws by rule: the same position for the third time, fifty moves each without a capture
+    // or pawn move, or too little material left to mate.
+    if (board.CountRepetitions() >= 2) {
+        state = GAME_STATE::S_DRAW_REPETITION;
+    } else if (board.GetState().halfmoveClock >= 100) {
+        state = GAME_STATE::S_DRAW_FIFTY_MOVES;
+    } else if (board.GetState().IsInsufficientMaterial()) {
+        state = GAME_STATE::S_DRAW_INSUFFICIENT_MATERIAL;
     }
 }
 
-void Game::FilterMovesThatLeadToCheck() {
-    for (auto& [piece, possibleMoves] : possibleMovesPerPiece) {
-        for (int i = possibleMoves.size() - 1; i >= 0; i--) {
-            Move& move = possibleMoves[i];
-
-            // If short castling or long castling, check for intermediary positions between king and rook.
-            if (move.type == MOVE_TYPE::SHORT_CASTLING || move.type == MOVE_TYPE::LONG_CASTLING) {
-                std::vector<Position> intermediaryPositions;
-
-                if (move.type == MOVE_TYPE::SHORT_CASTLING) {
-                    intermediaryPositions = {{piece->GetPosition().i, 5}, {piece->GetPosition().i, 6}};
-                } else {
-                    intermediaryPositions = {{piece->GetPosition().i, 3}, {piece->GetPosition().i, 2}};
-                }
-
-                for (const Position& position : intermediaryPositions) {
-                    if (board.MoveLeadsToCheck(piece, {MOVE_TYPE::WALK, position})) {
-                        possibleMoves.erase(possibleMoves.begin() + i);
-                        break;
-                    }
-                }
-
-            // If normal move.
-            } else if (board.MoveLeadsToCheck(piece, possibleMoves[i])) {
-                possibleMoves.erase(possibleMoves.begin() + i);
-            }
-        }
-    }
+bool Game::IsGameOver() const {
+    return state != GAME_STATE::S_RUNNING && state != GAME_STATE::S_PROMOTION && state != GAME_STATE::S_AI_THINKING;
 }
 
 bool Game::IsAnyMovePossible() {
@@ -338,25 +304,17 @@ void Game::UpdateAI() {
         // Start AI thinking
         state = GAME_STATE::S_AI_THINKING;
         
-        // Get the best move using minimax
-        std::pair<Piece*, Move> bestMove = ai->GetBestMove(board);
+        // Get the best move the AI finds within its thinking time
+        const GameConfig& config = GameConfig::GetInstance();
+        PackedMove bestMove = ai->GetBestMove(board, config.GetAIDepth(), config.GetAIThinkingTime());
         
         // Make sure the AI found a valid move
-        if (bestMove.first != nullptr) {
+        if (!bestMove.IsNone()) {
             // Play sound for AI move
             PlaySound(sounds["click"]);
             
-            // Make the AI move
-            board.DoMove(bestMove.first, bestMove.second);
-            
-            // Check if the move was a promotion
-            if (bestMove.second.type == MOVE_TYPE::PROMOTION || 
-                bestMove.second.type == MOVE_TYPE::ATTACK_AND_PROMOTION) {
-                // For AI, automatically choose queen for promotion
-                Piece* newPiece = new Queen(bestMove.first->GetPosition(), bestMove.first->color);
-                board.Destroy(bestMove.first->GetPosition());
-                board.Add(newPiece);
-            }
+            // Make the AI move (a promotion puts the piece the AI chose on the board)
+            board.DoMove(bestMove);
         }
         
         // Always return to running state and swap turns
@@ -10,6 +10,7 @@
 #include "raylib.h"
 #include "Move.h"
 #include "AI.h" // Add this include
+#include "Gameconfig.h"
 
 enum GAME_STATE {
     S_RUNNING,
@@ -17,6 +18,9 @@ enum GAME_STATE {
     S_WHITE_WINS,
     S_BLACK_WINS,
     S_STALEMATE,
+    S_DRAW_REPETITION,
+    S_DRAW_FIFTY_MOVES,
+    S_DRAW_INSUFFICIENT_MATERIAL,
     S_AI_THINKING // Add a new state for AI thinking
 };
 
@@ -51,9 +55,8 @@ private:
 
     void CalculateAllPossibleMovements();
     void CheckForEndOfGame();
-    void FilterMovesThatAttackOppositeKing();
-    void FilterMovesThatLeadToCheck();
     bool IsAnyMovePossible();
+    bool IsGameOver() const;
     
     // AI-related methods
     void UpdateAI();
@@ -71,6 +74,9 @@ private:
     // Selected piece/possible moves state.
     Piece* selectedPiece = nullptr;
     std::map<Piece*, std::vector<Move>> possibleMovesPerPiece;
+    // Square of the pawn being promoted while the promotion screen is up. The pawn's piece
+    // object is replaced as it moves, so it is found by square rather than kept selected.
+    Position promotionPosition = {0, 0};
 
     // Game information (current round and time).
     int round = 1;
@@ -78,8 +84,6 @@ private:
     
     // AI
     AI* ai;
-    float aiThinkingTimer;
-    const float AI_THINKING_TIME = 0.1f; // Reduced from 0.5f to 0.1f for faster response
 };
 
 #endif //RAY_CHESS_GAME_H
\ No newline at end of file
@@ -2,17 +2,14 @@
 #ifndef RAY_CHESS_GAMECONFIG_H
 #define RAY_CHESS_GAMECONFIG_H
 
+#include "pieces/PieceEnums.h"
+
 enum AI_DIFFICULTY {
     EASY,
     MEDIUM,
     HARD
 };
 
-enum class PIECE_COLOR {
-    C_WHITE,
-    C_BLACK
-};
-
 class GameConfig {
 public:
     static GameConfig& GetInstance() {
@@ -28,16 +25,31 @@ public:
         return aiDifficulty;
     }
     
+    // Deepest search the AI may do; it stops earlier when its thinking time runs out.
     int GetAIDepth() const {
         switch (aiDifficulty) {
             case EASY:
                 return 2;
             case MEDIUM:
-                return 3;
+                return 4;
             case HARD:
+                return 8;
+            default:
                 return 4;
+        }
+    }
+    
+    // Time the AI may take for a move, in milliseconds.
+    int GetAIThinkingTime() const {
+        switch (aiDifficulty) {
+            case EASY:
+                return 200;
+            case MEDIUM:
+                return 500;
+            case HARD:
+                return 1500;
             default:
-                return 3;
+                return 500;
         }
     }
     
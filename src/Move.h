@@ -1,7 +1,11 @@
 #ifndef RAY_CHESS_MOVE_H
 #define RAY_CHESS_MOVE_H
 
+#include "Bitboard.h"
 #include "Position.h"
+#include "pieces/PieceEnums.h"
+
+#include <cstdint>
 
 enum MOVE_TYPE {
     WALK,
@@ -19,4 +23,121 @@ struct Move {
     Position position;
 };
 
+// Move types as stored in a packed move. The first six match MOVE_TYPE; promotions are split
+// by the piece promoted to, in PIECE_TYPE order (rook, knight, bishop, queen).
+enum MOVE_FLAG {
+    F_WALK,
+    F_DOUBLE_WALK,
+    F_ATTACK,
+    F_SHORT_CASTLING,
+    F_LONG_CASTLING,
+    F_EN_PASSANT,
+    F_PROMOTION_ROOK,
+    F_PROMOTION_KNIGHT,
+    F_PROMOTION_BISHOP,
+    F_PROMOTION_QUEEN,
+    F_ATTACK_AND_PROMOTION_ROOK,
+    F_ATTACK_AND_PROMOTION_KNIGHT,
+    F_ATTACK_AND_PROMOTION_BISHOP,
+    F_ATTACK_AND_PROMOTION_QUEEN
+};
+
+// A whole move in 16 bits: origin square (bits 0-5), target square (bits 6-11) and flag
+// (bits 12-15). Unlike Move it knows where the piece comes from, so it can be played on any
+// board holding the position, and it is cheap to keep in move lists and tables. All zero
+// (a1 to a1) is never a real move and stands for "no move".
+class PackedMove {
+public:
+    PackedMove() = default;
+
+    PackedMove(int from, int to, MOVE_FLAG flag) : data(uint16_t(from | (to << 6) | (flag << 12))) {}
+
+    // The move of the piece on the from square, promoting to the given piece if it promotes.
+    static PackedMove Pack(int from, const Move& move, PIECE_TYPE promotionType = PIECE_TYPE::QUEEN) {
+        int flag = move.type;
+
+        if (move.type == MOVE_TYPE::PROMOTION) {
+            flag = F_PROMOTION_ROOK + (promotionType - PIECE_TYPE::ROOK);
+        } else if (move.type == MOVE_TYPE::ATTACK_AND_PROMOTION) {
+            flag = F_ATTACK_AND_PROMOTION_ROOK + (promotionType - PIECE_TYPE::ROOK);
+        }
+
+        return {from, Bitboards::SquareOf(move.position), MOVE_FLAG(flag)};
+    }
+
+    static PackedMove None() {
+        return {0, 0, F_WALK};
+    }
+
+    // The 16 bits as stored, e.g. for tables keyed or sorted by move.
+    static PackedMove FromRaw(uint16_t raw) {
+        PackedMove move;
+        move.data = raw;
+        return move;
+    }
+
+    uint16_t Raw() const {
+        return data;
+    }
+
+    bool IsNone() const {
+        return data == 0;
+    }
+
+    int From() const {
+        return data & 63;
+    }
+
+    int To() const {
+        return (data >> 6) & 63;
+    }
+
+    MOVE_FLAG Flag() const {
+        return MOVE_FLAG(data >> 12);
+    }
+
+    MOVE_TYPE Type() const {
+        MOVE_FLAG flag = Flag();
+
+        if (flag >= F_ATTACK_AND_PROMOTION_ROOK) {
+            return MOVE_TYPE::ATTACK_AND_PROMOTION;
+        } else if (flag >= F_PROMOTION_ROOK) {
+            return MOVE_TYPE::PROMOTION;
+        }
+
+        return MOVE_TYPE(flag);
+    }
+
+    bool IsPromotion() const {
+        return Flag() >= F_PROMOTION_ROOK;
+    }
+
+    bool IsCapture() const {
+        MOVE_FLAG flag = Flag();
+        return flag == F_ATTACK || flag == F_EN_PASSANT || flag >= F_ATTACK_AND_PROMOTION_ROOK;
+    }
+
+    // Only meaningful for promotions.
+    PIECE_TYPE PromotionType() const {
+        return PIECE_TYPE(PIECE_TYPE::ROOK + (Flag() - F_PROMOTION_ROOK) % 4);
+    }
+
+    Move ToMove() const {
+        return {Type(), Bitboards::PositionOf(To())};
+    }
+
+    bool operator==(const PackedMove& other) const {
+        return data == other.data;
+    }
+
+    bool operator!=(const PackedMove& other) const {
+        return data != other.data;
+    }
+
+private:
+    uint16_t data;
+};
+
+static_assert(sizeof(PackedMove) == 2, "PackedMove must stay 16 bits");
+
 #endif //RAY_CHESS_MOVE_H
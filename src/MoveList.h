@@ -0,0 +1,63 @@
+#ifndef RAY_CHESS_MOVELIST_H
+#define RAY_CHESS_MOVELIST_H
+
+#include "Move.h"
+
+// Fixed-capacity move list meant to live on the stack. Generators append to it in place, so
+// producing moves never touches the heap. The capacity is above the 218 legal moves of the
+// richest known position, leaving room for pseudo-legal ones.
+class MoveList {
+public:
+    static const int CAPACITY = 256;
+
+    void Add(PackedMove move) {
+        entries[count++] = move;
+    }
+
+    // Removes an entry by moving the last one into its place (order is not kept).
+    void RemoveAt(int index) {
+        entries[index] = entries[--count];
+    }
+
+    void Clear() {
+        count = 0;
+    }
+
+    int Size() const {
+        return count;
+    }
+
+    bool Empty() const {
+        return count == 0;
+    }
+
+    PackedMove& operator[](int index) {
+        return entries[index];
+    }
+
+    const PackedMove& operator[](int index) const {
+        return entries[index];
+    }
+
+    PackedMove* begin() {
+        return entries;
+    }
+
+    PackedMove* end() {
+        return entries + count;
+    }
+
+    const PackedMove* begin() const {
+        return entries;
+    }
+
+    const PackedMove* end() const {
+        return entries + count;
+    }
+
+private:
+    PackedMove entries[CAPACITY];
+    int count = 0;
+};
+
+#endif //RAY_CHESS_MOVELIST_H
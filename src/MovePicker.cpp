@@ -0,0 +1,213 @@
+#include "MovePicker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+    // Rough piece values in pawns, only used to compare the two sides of an exchange.
+    const int EXCHANGE_VALUES[6] = {1, 5, 3, 3, 9, 100};
+
+    // Puts captures ahead of quiet evasions.
+    const int CAPTURE_BONUS = 1 << 20;
+}
+
+void HistoryTable::Clear() {
+    std::fill(&scores[0][0][0], &scores[0][0][0] + 2 * 64 * 64, 0);
+}
+
+void HistoryTable::Update(PIECE_COLOR color, PackedMove move, int bonus) {
+    int& score = scores[color][move.From()][move.To()];
+    bonus = std::clamp(bonus, -MAX_SCORE, MAX_SCORE);
+    score += bonus - score * std::abs(bonus) / MAX_SCORE;
+}
+
+MovePicker::MovePicker(const BoardState& state, PIECE_COLOR color, PackedMove ttMove, PackedMove firstKiller, PackedMove secondKiller,
+                       const HistoryTable* history)
+    : state(state), color(color), history(history), ttMove(ttMove), killers{firstKiller, secondKiller} {}
+
+MovePicker::MovePicker(const BoardState& state, PIECE_COLOR color, GENERATION_TYPE type, const HistoryTable* history)
+    : state(state), color(color), history(history), capturesOnly(type == G_CAPTURES),
+      ttMove(PackedMove::None()), killers{PackedMove::None(), PackedMove::None()} {}
+
+PackedMove MovePicker::Next() {
+    while (true) {
+        switch (stage) {
+            case P_TT_MOVE:
+                stage = state.IsInCheck(color) ? P_GENERATE_EVASIONS : P_GENERATE_CAPTURES;
+
+                if (state.IsLegalMove(color, ttMove)) {
+                    return ttMove;
+                }
+                break;
+
+            case P_GENERATE_CAPTURES:
+                state.GetLegalMoves(color, captures, G_CAPTURES);
+
+                for (int i = 0; i < captures.Size(); i++) {
+                    scores[i] = CaptureScore(captures[i]);
+                }
+
+                index = 0;
+                stage = P_WINNING_CAPTURES;
+                break;
+
+            case P_WINNING_CAPTURES:
+                while (index < captures.Size()) {
+                    PickBest(captures, index);
+                    PackedMove move = captures[index++];
+
+                    if (move == ttMove) {
+                        continue;
+                    }
+
+                    if (IsWinningCapture(move)) {
+                        return move;
+                    }
+
+                    captures[losingCaptureCount++] = move;
+                }
+
+                index = 0;
+                stage = capturesOnly ? P_DONE : P_KILLERS;
+                break;
+
+            case P_KILLERS:
+                while (index < 2) {
+                    PackedMove killer = killers[index++];
+
+                    // Killers are quiet moves; captures were already handed out above.
+                    if (killer != ttMove && !killer.IsCapture() && !killer.IsPromotion() &&
+                        (index == 1 || killer != killers[0]) &&
+                        state.IsLegalMove(color, killer)
+                    ) {
+                        return killer;
+                    }
+                }
+
+                stage = P_GENERATE_QUIETS;
+                break;
+
+            case P_GENERATE_QUIETS:
+                state.GetLegalMoves(color, quiets, G_QUIETS);
+
+                for (int i = 0; i < quiets.Size(); i++) {
+                    scores[i] = QuietScore(quiets[i]);
+                }
+
+                index = 0;
+                stage = P_QUIETS;
+                break;
+
+            case P_QUIETS:
+                while (index < quiets.Size()) {
+                    // Without a history table every quiet move scores the same.
+                    if (history) {
+                        PickBest(quiets, index);
+                    }
+
+                    PackedMove move = quiets[index++];
+
+                    if (move != ttMove && !IsKiller(move)) {
+                        return move;
+                    }
+                }
+
+                index = 0;
+                stage = P_LOSING_CAPTURES;
+                break;
+
+            case P_LOSING_CAPTURES:
+                if (index < losingCaptureCount) {
+                    return captures[index++];
+                }
+
+                stage = P_DONE;
+                break;
+
+            case P_GENERATE_EVASIONS:
+                state.GetLegalMoves(color, captures, G_EVASIONS);
+
+                for (int i = 0; i < captures.Size(); i++) {
+                    PackedMove move = captures[i];
+                    scores[i] = move.IsCapture() || move.IsPromotion() ? CAPTURE_BONUS + CaptureScore(move) : QuietScore(move);
+                }
+
+                index = 0;
+                stage = P_EVASIONS;
+                break;
+
+            case P_EVASIONS:
+                while (index < captures.Size()) {
+                    PickBest(captures, index);
+                    PackedMove move = captures[index++];
+
+                    if (move != ttMove) {
+                        return move;
+                    }
+                }
+
+                stage = P_DONE;
+                break;
+
+            default:
+                return PackedMove::None();
+        }
+    }
+}
+
+bool MovePicker::IsWinningCapture(PackedMove move) const {
+    // Promotions and en passant (a pawn for a pawn) never lose material by themselves.
+    if (!move.IsCapture() || move.Flag() == F_EN_PASSANT) {
+        return true;
+    }
+
+    int attackerValue = EXCHANGE_VALUES[state.TypeAt(move.From())];
+    int victimValue = EXCHANGE_VALUES[state.TypeAt(move.To())];
+
+    if (victimValue >= attackerValue) {
+        return true;
+    }
+
+    // Capturing with the more valuable piece only pays if nothing can take it back.
+    Bitboard occupiedAfter = state.GetOccupied() ^ Bitboards::SquareBit(move.From());
+    return !state.IsSquareAttacked(move.To(), PIECE_COLOR(color ^ 1), occupiedAfter);
+}
+
+bool MovePicker::IsKiller(PackedMove move) const {
+    return move == killers[0] || move == killers[1];
+}
+
+int MovePicker::CaptureScore(PackedMove move) const {
+    int score = 0;
+
+    // En passant takes a pawn from a square that looks empty.
+    if (move.IsCapture()) {
+        int victimValue = move.Flag() == F_EN_PASSANT ? EXCHANGE_VALUES[PIECE_TYPE::PEON] : EXCHANGE_VALUES[state.TypeAt(move.To())];
+        score += victimValue * 16 - EXCHANGE_VALUES[state.TypeAt(move.From())];
+    }
+
+    // A promotion gains about as much as capturing the piece promoted to.
+    if (move.IsPromotion()) {
+        score += EXCHANGE_VALUES[move.PromotionType()] * 16;
+    }
+
+    return score;
+}
+
+int MovePicker::QuietScore(PackedMove move) const {
+    return history ? history->Get(color, move) : 0;
+}
+
+void MovePicker::PickBest(MoveList& moves, int index) {
+    int best = index;
+
+    for (int i = index + 1; i < moves.Size(); i++) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+}
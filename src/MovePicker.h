@@ -0,0 +1,94 @@
+#ifndef RAY_CHESS_MOVEPICKER_H
+#define RAY_CHESS_MOVEPICKER_H
+
+#include "BoardState.h"
+#include "Move.h"
+#include "MoveList.h"
+
+// How often quiet moves caused a cutoff in earlier searches, by side, origin and destination
+// square. Moves that cut off gain and the quiet moves tried before them lose, by the square of
+// the remaining depth; scores are pulled towards zero as they grow, so they stay within
+// [-MAX_SCORE, MAX_SCORE] and recent results count most.
+struct HistoryTable {
+    static constexpr int MAX_SCORE = 16384;
+
+    void Clear();
+    void Update(PIECE_COLOR color, PackedMove move, int bonus);
+
+    int Get(PIECE_COLOR color, PackedMove move) const {
+        return scores[color][move.From()][move.To()];
+    }
+
+    int scores[2][64][64];
+};
+
+// Hands out the legal moves of a position one at a time, best guesses first: the
+// transposition table move, captures that do not lose material, killer moves, the remaining
+// quiet moves and finally captures that do. Captures come most valuable victim first, then
+// least valuable attacker first (MVV-LVA), and quiet moves by their history score. Each group
+// is generated only once the previous one is used up, so a node that cuts off early skips
+// most of the generation work. In check, the few evasions are generated in one go after the
+// transposition table move, captures first.
+//
+// The position must be the same on every call to Next (moves made on it in between have to
+// be unmade).
+class MovePicker {
+public:
+    MovePicker(const BoardState& state, PIECE_COLOR color,
+               PackedMove ttMove = PackedMove::None(),
+               PackedMove firstKiller = PackedMove::None(),
+               PackedMove secondKiller = PackedMove::None(),
+               const HistoryTable* history = nullptr);
+    // For quiescence search: with G_CAPTURES only the captures (and promotions) that do not
+    // lose material are handed out, though still every evasion when in check. Any other type
+    // hands out all moves, like the constructor above without hints.
+    MovePicker(const BoardState& state, PIECE_COLOR color, GENERATION_TYPE type, const HistoryTable* history = nullptr);
+
+    // The next move, or PackedMove::None() once all have been handed out.
+    PackedMove Next();
+
+private:
+    enum PICK_STAGE {
+        P_TT_MOVE,
+        P_GENERATE_CAPTURES,
+        P_WINNING_CAPTURES,
+        P_KILLERS,
+        P_GENERATE_QUIETS,
+        P_QUIETS,
+        P_LOSING_CAPTURES,
+        P_GENERATE_EVASIONS,
+        P_EVASIONS,
+        P_DONE
+    };
+
+    bool IsWinningCapture(PackedMove move) const;
+    bool IsKiller(PackedMove move) const;
+
+    int CaptureScore(PackedMove move) const;
+    int QuietScore(PackedMove move) const;
+    // Moves the best scored of the moves from index on to index (one step of a selection sort,
+    // so moves after a cutoff are never sorted).
+    void PickBest(MoveList& moves, int index);
+
+    const BoardState& state;
+    PIECE_COLOR color;
+    const HistoryTable* history;
+    bool capturesOnly = false;
+
+    PackedMove ttMove;
+    PackedMove killers[2];
+
+    PICK_STAGE stage = P_TT_MOVE;
+    int index = 0;
+
+    // Captures, or all evasions when in check.
+    MoveList captures;
+    // Losing captures are moved to the front of the capture list as it is walked.
+    int losingCaptureCount = 0;
+    MoveList quiets;
+
+    // Ordering score of each move in the list being handed out.
+    int scores[MoveList::CAPACITY];
+};
+
+#endif //RAY_CHESS_MOVEPICKER_H
@@ -137,6 +137,12 @@ void Renderer::RenderEndScreen(GAME_STATE state) {
         text = "Black wins";
     } else if (state == GAME_STATE::S_STALEMATE) {
         text = "Stalemate";
+    } else if (state == GAME_STATE::S_DRAW_REPETITION) {
+        text = "Draw by repetition";
+    } else if (state == GAME_STATE::S_DRAW_FIFTY_MOVES) {
+        text = "Draw by fifty-move rule";
+    } else {
+        text = "Draw by insufficient material";
     }
 
     int textLength = MeasureText(text, 40);
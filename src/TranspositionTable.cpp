@@ -0,0 +1,115 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    Resize(megabytes);
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+    size_t count = 1;
+
+    while (count * 2 * sizeof(Bucket) <= megabytes << 20) {
+        count *= 2;
+    }
+
+    buckets.reset(new Bucket[count]);
+    mask = count - 1;
+    Clear();
+}
+
+void TranspositionTable::Clear() {
+    for (size_t index = 0; index <= mask; index++) {
+        for (Entry& entry : buckets[index].entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    generation = 0;
+}
+
+void TranspositionTable::NewSearch() {
+    generation = (generation + 1) & GENERATION_MASK;
+}
+
+uint64_t TranspositionTable::Pack(PackedMove move, int score, int depth, BOUND_TYPE bound, int generation) {
+    return uint64_t(move.Raw()) |
+           uint64_t(uint16_t(int16_t(score))) << 16 |
+           uint64_t(uint8_t(depth)) << 32 |
+           uint64_t(bound) << 40 |
+           uint64_t(generation) << 42;
+}
+
+bool TranspositionTable::Probe(uint64_t key, TTData& data) const {
+    for (const Entry& entry : BucketOf(key).entries) {
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+
+        if ((entry.check.load(std::memory_order_relaxed) ^ entryData) != key || BoundOf(entryData) == B_NONE) {
+            continue;
+        }
+
+        data.move = PackedMove::FromRaw(uint16_t(entryData));
+        data.score = int16_t(uint16_t(entryData >> 16));
+        data.depth = DepthOf(entryData);
+        data.bound = BoundOf(entryData);
+        return true;
+    }
+
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t key, PackedMove move, int score, int depth, BOUND_TYPE bound) {
+    Entry* replaced = nullptr;
+    uint64_t replacedData = 0;
+    bool isSamePosition = false;
+
+    for (Entry& entry : BucketOf(key).entries) {
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+        isSamePosition = (entry.check.load(std::memory_order_relaxed) ^ entryData) == key;
+
+        // The position's own entry, or a free one, is always taken.
+        if (isSamePosition || BoundOf(entryData) == B_NONE) {
+            replaced = &entry;
+            replacedData = entryData;
+            break;
+        }
+
+        if (!replaced || ReplacementValue(entryData) < ReplacementValue(replacedData)) {
+            replaced = &entry;
+            replacedData = entryData;
+        }
+    }
+
+    if (isSamePosition && BoundOf(replacedData) != B_NONE) {
+        // A much deeper bound from this search is worth more than a shallow one.
+        if (bound != B_EXACT && GenerationOf(replacedData) == generation && depth + 2 < DepthOf(replacedData)) {
+            return;
+        }
+
+        if (move.IsNone()) {
+            move = PackedMove::FromRaw(uint16_t(replacedData));
+        }
+    }
+
+    uint64_t data = Pack(move, score, depth, bound, generation);
+
+    replaced->data.store(data, std::memory_order_relaxed);
+    replaced->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::GetHashFull() const {
+    const size_t SAMPLE_BUCKETS = 250;
+
+    size_t sampled = std::min(SAMPLE_BUCKETS, mask + 1);
+    int used = 0;
+
+    for (size_t index = 0; index < sampled; index++) {
+        for (const Entry& entry : buckets[index].entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            used += BoundOf(data) != B_NONE && GenerationOf(data) == generation;
+        }
+    }
+
+    return int(used * 1000 / (sampled * BUCKET_SIZE));
+}
@@ -0,0 +1,105 @@
+#ifndef RAY_CHESS_TRANSPOSITIONTABLE_H
+#define RAY_CHESS_TRANSPOSITIONTABLE_H
+
+#include "Move.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// How a stored score relates to the real score of the position.
+enum BOUND_TYPE {
+    B_NONE,
+    // The search failed low: the score is at most the stored one.
+    B_UPPER,
+    // The search failed high: the score is at least the stored one.
+    B_LOWER,
+    B_EXACT
+};
+
+// What the table remembers about a searched position.
+struct TTData {
+    PackedMove move;
+    int score;
+    int depth;
+    BOUND_TYPE bound;
+};
+
+// Search results by Zobrist key. Entries are grouped into buckets of one cache line and a key
+// can only go into its own bucket, so a probe touches a single line. When the bucket is full,
+// the entry that is shallowest and oldest (stored by an earlier search) gives way.
+//
+// Any number of threads may probe and store at the same time without locks. An entry is two
+// words written one after the other, the data and the key XORed with the data, so an entry
+// half overwritten by another thread no longer matches its key and reads as a miss. Racing
+// stores can still lose one of the results, which only costs a re-search.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes);
+
+    // Drops all entries and takes the largest power-of-two number of buckets that fits in the
+    // given size.
+    void Resize(size_t megabytes);
+    void Clear();
+    // Starts a new search: entries stored until now become one search older. Unlike probes
+    // and stores, this (and Resize and Clear) must not run while other threads use the table.
+    void NewSearch();
+
+    bool Probe(uint64_t key, TTData& data) const;
+    // A move of PackedMove::None() keeps the move already stored for the position, if any.
+    void Store(uint64_t key, PackedMove move, int score, int depth, BOUND_TYPE bound);
+
+    // Permille of entries written by the current search, from a sample at the start of the table.
+    int GetHashFull() const;
+
+    size_t GetSizeInBytes() const {
+        return (mask + 1) * sizeof(Bucket);
+    }
+
+private:
+    // The data word packs the move (bits 0-15), the score (16-31), the depth (32-39), the bound
+    // (40-41) and the search generation (42-47). An entry whose bound is B_NONE is empty.
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    static const int BUCKET_SIZE = 4;
+    static const int GENERATION_MASK = 63;
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    static_assert(sizeof(Bucket) == 64, "A bucket should fill exactly one cache line");
+
+    static uint64_t Pack(PackedMove move, int score, int depth, BOUND_TYPE bound, int generation);
+
+    static BOUND_TYPE BoundOf(uint64_t data) {
+        return BOUND_TYPE((data >> 40) & 3);
+    }
+
+    static int DepthOf(uint64_t data) {
+        return int((data >> 32) & 255);
+    }
+
+    static int GenerationOf(uint64_t data) {
+        return int(data >> 42) & GENERATION_MASK;
+    }
+
+    // Lower values are replaced first: every search an entry is old costs it eight plies of depth.
+    int ReplacementValue(uint64_t data) const {
+        return DepthOf(data) - 8 * ((generation - GenerationOf(data)) & GENERATION_MASK);
+    }
+
+    Bucket& BucketOf(uint64_t key) const {
+        return buckets[key & mask];
+    }
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t mask = 0;
+    int generation = 0;
+};
+
+#endif //RAY_CHESS_TRANSPOSITIONTABLE_H
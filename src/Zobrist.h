@@ -0,0 +1,54 @@
+#ifndef RAY_CHESS_ZOBRIST_H
+#define RAY_CHESS_ZOBRIST_H
+
+#include "pieces/PieceEnums.h"
+
+#include <cstdint>
+
+// Random numbers whose XOR identifies a position: one per piece kind on each square, one per
+// castling-rights mask, one per en passant file and one for black to move. The compiler
+// generates them from a fixed seed, so keys are the same on every run and build.
+namespace Zobrist {
+    struct Keys {
+        uint64_t pieces[2][6][64];
+        uint64_t castling[16];
+        uint64_t enPassantFile[8];
+        uint64_t blackToMove;
+    };
+
+    // SplitMix64: one step of a 64-bit generator with well-mixed output.
+    constexpr uint64_t NextRandom(uint64_t& seed) {
+        uint64_t value = (seed += 0x9E3779B97F4A7C15ULL);
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+
+    constexpr Keys GenerateKeys() {
+        Keys keys = {};
+        uint64_t seed = 0x5241594348455353ULL;
+
+        for (auto& colorKeys : keys.pieces) {
+            for (auto& typeKeys : colorKeys) {
+                for (uint64_t& key : typeKeys) {
+                    key = NextRandom(seed);
+                }
+            }
+        }
+
+        for (uint64_t& key : keys.castling) {
+            key = NextRandom(seed);
+        }
+
+        for (uint64_t& key : keys.enPassantFile) {
+            key = NextRandom(seed);
+        }
+
+        keys.blackToMove = NextRandom(seed);
+        return keys;
+    }
+
+    inline constexpr Keys KEYS = GenerateKeys();
+}
+
+#endif //RAY_CHESS_ZOBRIST_H
@@ -14,7 +14,6 @@ Piece::Piece(Position position, PIECE_COLOR color, PIECE_TYPE type): position(po
 }
 
 void Piece::DoMove(const Move &move) {
-    hasMoved = true;
     position = move.position;
 }
 
@@ -26,10 +25,6 @@ std::string Piece::GetName() {
     return name;
 }
 
-bool Piece::HasMoved() {
-    return hasMoved;
-}
-
 Piece* Piece::CreatePieceByType(PIECE_TYPE type, const Position& position, PIECE_COLOR color) {
     switch (type) {
         case PEON:
@@ -10,8 +10,9 @@ class Piece; // Forward declaration (circular dependency).
 #include "PieceEnums.h"
 
 #include <string>
-#include <vector>
 
+// A piece as the game and renderer see it. Everything the rules need (castling rights, en
+// passant) is kept in the board state, so a piece is just a type, a color and a square.
 class Piece {
 public:
     Piece(Position position, PIECE_COLOR color, PIECE_TYPE type);
@@ -21,19 +22,16 @@ public:
     static PIECE_COLOR GetInverseColor(PIECE_COLOR color);
     static std::string GetPieceCharacterByType(PIECE_TYPE type);
 
-    virtual void DoMove(const Move& move);
-    virtual std::vector<Move> GetPossibleMoves(const Board& board) = 0;
+    void DoMove(const Move& move);
 
     Position GetPosition();
     std::string GetName();
-    bool HasMoved();
 
     const PIECE_COLOR color;
     const PIECE_TYPE type;
 
 protected:
     Position position;
-    bool hasMoved = false;
 
 private:
     std::string name;
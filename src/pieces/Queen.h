@@ -7,10 +7,6 @@
 class Queen : public Piece {
 public:
     Queen(Position position, PIECE_COLOR color): Piece(position, color, PIECE_TYPE::QUEEN) {}
-    std::vector<Move> GetPossibleMoves(const Board& board) override;
-
-private:
-    void AddValidMoves(const Board& board, std::vector<Move>& moves, Position pos, int iIncrement, int jIncrement);
 };
 
 #endif //RAY_CHESS_QUEEN_H
@@ -0,0 +1,717 @@
+// Headless micro-benchmarks and self-checks for the board core (`make bench`).
+#include "AI.h"
+#include "Board.h"
+#include "MovePicker.h"
+#include "TranspositionTable.h"
+#include "Zobrist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Keeps the compiler from discarding or hoisting a value computed inside a timed loop.
+    template <typename T>
+    void Consume(const T& value) {
+        asm volatile("" : : "r"(value) : "memory");
+    }
+
+    template <typename Function>
+    double NanosecondsPerCall(Function function, long calls) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / calls;
+    }
+
+    // The previous Board::At: a linear scan over both piece lists.
+    Piece* ScanAt(const std::vector<Piece*>& whitePieces, const std::vector<Piece*>& blackPieces, const Position& position) {
+        for (Piece* whitePiece : whitePieces) {
+            if (whitePiece->GetPosition().i == position.i && whitePiece->GetPosition().j == position.j) {
+                return whitePiece;
+            }
+        }
+
+        for (Piece* blackPiece : blackPieces) {
+            if (blackPiece->GetPosition().i == position.i && blackPiece->GetPosition().j == position.j) {
+                return blackPiece;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void BenchSquareLookup() {
+        const int ROUNDS = 200000;
+        const long CALLS = ROUNDS * 64L;
+
+        Board board;
+        board.Init();
+
+        std::vector<Piece*> whitePieces = board.GetPiecesByColor(PIECE_COLOR::C_WHITE);
+        std::vector<Piece*> blackPieces = board.GetPiecesByColor(PIECE_COLOR::C_BLACK);
+
+        double scanCost = NanosecondsPerCall([&]() {
+            for (int round = 0; round < ROUNDS; round++) {
+                for (int i = 0; i < 8; i++) {
+                    for (int j = 0; j < 8; j++) {
+                        Consume(ScanAt(whitePieces, blackPieces, {i, j}));
+                    }
+                }
+            }
+        }, CALLS);
+
+        double mailboxCost = NanosecondsPerCall([&]() {
+            for (int round = 0; round < ROUNDS; round++) {
+                for (int i = 0; i < 8; i++) {
+                    for (int j = 0; j < 8; j++) {
+                        Consume(board.At({i, j}));
+                    }
+                }
+            }
+        }, CALLS);
+
+        std::printf("Board::At (initial position, all 64 squares)\n");
+        std::printf("  linear scan: %8.2f ns/call\n", scanCost);
+        std::printf("  mailbox:     %8.2f ns/call (%.1fx)\n", mailboxCost, scanCost / mailboxCost);
+    }
+
+    // The previous slider generation: walk each ray square by square until a blocker.
+    Bitboard RayWalkQueenAttacks(int square, Bitboard occupied) {
+        const int DIRECTIONS[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+        Bitboard attacks = 0;
+
+        for (const auto& direction : DIRECTIONS) {
+            int rank = square / 8 + direction[0];
+            int file = square % 8 + direction[1];
+
+            while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                Bitboard bit = Bitboards::SquareBit(rank * 8 + file);
+                attacks |= bit;
+
+                if (occupied & bit) {
+                    break;
+                }
+
+                rank += direction[0];
+                file += direction[1];
+            }
+        }
+
+        return attacks;
+    }
+
+    // Leaf count of the legal move tree below the board, using the copy-based move path.
+    long PerftCopy(Board& board, PIECE_COLOR color, int depth) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        long nodes = 0;
+
+        MoveList moves;
+
+        board.GetPseudoLegalMoves(color, moves);
+
+        for (PackedMove move : moves) {
+            if (board.MoveLeadsToCheck(board.At(Bitboards::PositionOf(move.From())), move.ToMove())) {
+                continue;
+            }
+
+            Board boardCopy = board;
+            boardCopy.DoMove(move);
+
+            nodes += PerftCopy(boardCopy, Piece::GetInverseColor(color), depth - 1);
+        }
+
+        return nodes;
+    }
+
+    // Same count, making and unmaking moves on a single board.
+    long PerftMakeUnmake(Board& board, PIECE_COLOR color, int depth) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        long nodes = 0;
+
+        MoveList moves;
+
+        board.GetPseudoLegalMoves(color, moves);
+
+        for (PackedMove move : moves) {
+            board.MakeMove(move);
+
+            if (board.IsInCheck(color)) {
+                board.UnmakeMove();
+                continue;
+            }
+
+            nodes += PerftMakeUnmake(board, Piece::GetInverseColor(color), depth - 1);
+            board.UnmakeMove();
+        }
+
+        return nodes;
+    }
+
+    // Same count, taking moves from the legal generator instead of filtering pseudo-legal ones.
+    long PerftLegal(Board& board, PIECE_COLOR color, int depth) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        long nodes = 0;
+
+        MoveList moves;
+        board.GetLegalMoves(color, moves);
+
+        for (PackedMove move : moves) {
+            board.MakeMove(move);
+            nodes += PerftLegal(board, Piece::GetInverseColor(color), depth - 1);
+            board.UnmakeMove();
+        }
+
+        return nodes;
+    }
+
+    // Same count, playing each legal move on a copy of the position state (copy-make) instead
+    // of unmaking it.
+    long PerftCopyMake(const BoardState& state, int depth) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        long nodes = 0;
+
+        MoveList moves;
+        state.GetLegalMoves(state.sideToMove, moves);
+
+        for (PackedMove move : moves) {
+            BoardState child = state;
+            child.MakeMove(move);
+
+            nodes += PerftCopyMake(child, depth - 1);
+        }
+
+        return nodes;
+    }
+
+    // Same count, taking moves one at a time from the staged move picker.
+    long PerftPicker(Board& board, PIECE_COLOR color, int depth) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        long nodes = 0;
+        MovePicker picker(board.GetState(), color);
+
+        for (PackedMove move = picker.Next(); !move.IsNone(); move = picker.Next()) {
+            board.MakeMove(move);
+            nodes += PerftPicker(board, Piece::GetInverseColor(color), depth - 1);
+            board.UnmakeMove();
+        }
+
+        return nodes;
+    }
+
+    std::vector<uint16_t> SortedMoves(const MoveList& moves) {
+        std::vector<uint16_t> rawMoves;
+
+        for (PackedMove move : moves) {
+            rawMoves.push_back(move.Raw());
+        }
+
+        std::sort(rawMoves.begin(), rawMoves.end());
+        return rawMoves;
+    }
+
+    // Walks the legal move tree and counts the nodes where the specialized generators disagree
+    // with the full one: captures and quiet moves must split the legal moves between them, and
+    // in check the evasions must be exactly the legal moves.
+    long CountGeneratorMismatches(Board& board, PIECE_COLOR color, int depth, long& nodes) {
+        nodes++;
+
+        MoveList moves, captures, quiets;
+        board.GetLegalMoves(color, moves);
+        board.GetLegalMoves(color, captures, G_CAPTURES);
+        board.GetLegalMoves(color, quiets, G_QUIETS);
+
+        MoveList expectedCaptures, expectedQuiets;
+
+        for (PackedMove move : moves) {
+            (move.IsCapture() || move.IsPromotion() ? expectedCaptures : expectedQuiets).Add(move);
+        }
+
+        long mismatches = 0;
+
+        if (SortedMoves(captures) != SortedMoves(expectedCaptures) || SortedMoves(quiets) != SortedMoves(expectedQuiets)) {
+            mismatches++;
+        }
+
+        if (board.IsInCheck(color)) {
+            MoveList evasions;
+            board.GetLegalMoves(color, evasions, G_EVASIONS);
+
+            if (SortedMoves(evasions) != SortedMoves(moves)) {
+                mismatches++;
+            }
+        }
+
+        if (depth > 1) {
+            for (PackedMove move : moves) {
+                board.MakeMove(move);
+                mismatches += CountGeneratorMismatches(board, Piece::GetInverseColor(color), depth - 1, nodes);
+                board.UnmakeMove();
+            }
+        }
+
+        return mismatches;
+    }
+
+    // The benches and checks below return how many of their checks failed.
+    int BenchSliderAttacks() {
+        const int OCCUPANCIES = 4096;
+        const int ROUNDS = 100;
+        const long CALLS = long(OCCUPANCIES) * 64 * ROUNDS;
+        const int PERFT_DEPTH = 4;
+
+        // Sparse random occupancies, roughly middlegame density.
+        std::vector<Bitboard> occupancies(OCCUPANCIES);
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+        for (Bitboard& occupied : occupancies) {
+            occupied = ~Bitboard(0);
+
+            for (int k = 0; k < 2; k++) {
+                seed ^= seed >> 12;
+                seed ^= seed << 25;
+                seed ^= seed >> 27;
+                occupied &= seed * 2685821657736338717ULL;
+            }
+        }
+
+        double rayWalkCost = NanosecondsPerCall([&]() {
+            for (int round = 0; round < ROUNDS; round++) {
+                for (Bitboard occupied : occupancies) {
+                    for (int square = 0; square < 64; square++) {
+                        Consume(RayWalkQueenAttacks(square, occupied));
+                    }
+                }
+            }
+        }, CALLS);
+
+        std::printf("Queen attacks (%d random occupancies, all 64 squares)\n", OCCUPANCIES);
+        std::printf("  ray walk:    %8.2f ns/call\n", rayWalkCost);
+
+        Bitboards::ATTACK_BACKEND defaultBackend = Bitboards::attackBackend;
+        const Bitboards::ATTACK_BACKEND BACKENDS[2] = {Bitboards::B_MAGIC, Bitboards::B_PEXT};
+        const char* BACKEND_NAMES[2] = {"magic", "pext"};
+        long perftNodes[2] = {-1, -1};
+        int failures = 0;
+
+        for (int b = 0; b < 2; b++) {
+            bool available = true;
+            double initCost = NanosecondsPerCall([&]() { available = Bitboards::SetAttackBackend(BACKENDS[b]); }, 1);
+
+            if (!available) {
+                std::printf("  %-6s       unavailable on this CPU/build\n", BACKEND_NAMES[b]);
+                continue;
+            }
+
+            int attackMismatches = 0;
+
+            for (Bitboard occupied : occupancies) {
+                for (int square = 0; square < 64; square++) {
+                    attackMismatches += Bitboards::QueenAttacks(square, occupied) != RayWalkQueenAttacks(square, occupied);
+                }
+            }
+
+            if (attackMismatches > 0) {
+                std::printf("  %-6s       slider attacks MISMATCH on %d lookups\n", BACKEND_NAMES[b], attackMismatches);
+                failures++;
+                continue;
+            }
+
+            double lookupCost = NanosecondsPerCall([&]() {
+                for (int round = 0; round < ROUNDS; round++) {
+                    for (Bitboard occupied : occupancies) {
+                        for (int square = 0; square < 64; square++) {
+                            Consume(Bitboards::QueenAttacks(square, occupied));
+                        }
+                    }
+                }
+            }, CALLS);
+
+            Board board;
+            board.Init();
+
+            auto start = std::chrono::steady_clock::now();
+            perftNodes[b] = PerftLegal(board, PIECE_COLOR::C_WHITE, PERFT_DEPTH);
+            std::chrono::duration<double> perftTime = std::chrono::steady_clock::now() - start;
+
+            std::printf("  %-6s       %8.2f ns/call (%.1fx), table init %.3f ms, perft(%d) = %ld in %.2f s\n",
+                        BACKEND_NAMES[b], lookupCost, rayWalkCost / lookupCost, initCost / 1e6,
+                        PERFT_DEPTH, perftNodes[b], perftTime.count());
+        }
+
+        if (perftNodes[0] >= 0 && perftNodes[1] >= 0 && perftNodes[0] != perftNodes[1]) {
+            std::printf("  perft MISMATCH between backends\n");
+            failures++;
+        }
+
+        Bitboards::SetAttackBackend(defaultBackend);
+        return failures;
+    }
+
+    int BenchMoveMaking() {
+        const int PERFT_DEPTH = 4;
+
+        Board board;
+        board.Init();
+
+        auto start = std::chrono::steady_clock::now();
+        long copyNodes = PerftCopy(board, PIECE_COLOR::C_WHITE, PERFT_DEPTH);
+        std::chrono::duration<double> copyTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        long makeUnmakeNodes = PerftMakeUnmake(board, PIECE_COLOR::C_WHITE, PERFT_DEPTH);
+        std::chrono::duration<double> makeUnmakeTime = std::chrono::steady_clock::now() - start;
+
+        std::printf("Move making (perft(%d) from the initial position)\n", PERFT_DEPTH);
+        std::printf("  copy board:  %ld nodes in %.2f s\n", copyNodes, copyTime.count());
+        start = std::chrono::steady_clock::now();
+        long legalNodes = PerftLegal(board, PIECE_COLOR::C_WHITE, PERFT_DEPTH);
+        std::chrono::duration<double> legalTime = std::chrono::steady_clock::now() - start;
+
+        std::printf("  make/unmake: %ld nodes in %.2f s (%.1fx)%s\n", makeUnmakeNodes, makeUnmakeTime.count(),
+                    copyTime.count() / makeUnmakeTime.count(), copyNodes == makeUnmakeNodes ? "" : "  MISMATCH");
+        std::printf("  legal moves: %ld nodes in %.2f s (%.1fx)%s\n", legalNodes, legalTime.count(),
+                    copyTime.count() / legalTime.count(), copyNodes == legalNodes ? "" : "  MISMATCH");
+
+        start = std::chrono::steady_clock::now();
+        long copyMakeNodes = PerftCopyMake(board.GetState(), PERFT_DEPTH);
+        std::chrono::duration<double> copyMakeTime = std::chrono::steady_clock::now() - start;
+
+        std::printf("  copy-make:   %ld nodes in %.2f s (%.1fx)%s\n", copyMakeNodes, copyMakeTime.count(),
+                    copyTime.count() / copyMakeTime.count(), copyNodes == copyMakeNodes ? "" : "  MISMATCH");
+
+        start = std::chrono::steady_clock::now();
+        long pickerNodes = PerftPicker(board, PIECE_COLOR::C_WHITE, PERFT_DEPTH);
+        std::chrono::duration<double> pickerTime = std::chrono::steady_clock::now() - start;
+
+        std::printf("  move picker: %ld nodes in %.2f s (%.1fx)%s\n", pickerNodes, pickerTime.count(),
+                    copyTime.count() / pickerTime.count(), copyNodes == pickerNodes ? "" : "  MISMATCH");
+
+        return (makeUnmakeNodes != copyNodes) + (legalNodes != copyNodes) + (copyMakeNodes != copyNodes) + (pickerNodes != copyNodes);
+    }
+
+    // The AI search as it was before the negamax rewrite: minimax with alpha-beta and a branch
+    // per side, moves tried in generation order (no ordering, killers or draw detection) and
+    // every root move searched with the full window. Scores are for the AI's side. Only the
+    // node count is compared, so moves are made and unmade rather than played on board copies.
+    int OriginalMinimax(const AI& ai, PIECE_COLOR aiColor, Board& board, int depth, int alpha, int beta, long& nodes) {
+        nodes++;
+
+        if (depth == 0) {
+            return ai.Evaluate(board.GetState(), aiColor);
+        }
+
+        PIECE_COLOR currentColor = board.GetState().sideToMove;
+        MoveList moves;
+        board.GetLegalMoves(currentColor, moves);
+
+        if (currentColor == aiColor) {
+            int maxEval = -AI::INFINITE_SCORE;
+
+            for (PackedMove move : moves) {
+                board.MakeMove(move);
+                int eval = OriginalMinimax(ai, aiColor, board, depth - 1, alpha, beta, nodes);
+                board.UnmakeMove();
+
+                maxEval = std::max(maxEval, eval);
+                alpha = std::max(alpha, eval);
+
+                if (beta <= alpha) {
+                    break;
+                }
+            }
+
+            return maxEval;
+        } else {
+            int minEval = AI::INFINITE_SCORE;
+
+            for (PackedMove move : moves) {
+                board.MakeMove(move);
+                int eval = OriginalMinimax(ai, aiColor, board, depth - 1, alpha, beta, nodes);
+                board.UnmakeMove();
+
+                minEval = std::min(minEval, eval);
+                beta = std::min(beta, eval);
+
+                if (beta <= alpha) {
+                    break;
+                }
+            }
+
+            return minEval;
+        }
+    }
+
+    void BenchSearch() {
+        const int SEARCH_DEPTH = 4;
+
+        const struct {
+            const char* name;
+            const char* fen;
+        } POSITIONS[] = {
+            {"initial", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+            {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+            {"italian", "r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQK2R w KQkq - 1 5"},
+            {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}
+        };
+
+        // The PVS count includes the quiescence nodes below the nominal depth.
+        std::printf("Search (depth %d, nodes visited)\n", SEARCH_DEPTH);
+
+        for (const auto& position : POSITIONS) {
+            Board board;
+            PIECE_COLOR turn;
+            board.LoadFen(position.fen, turn);
+
+            AI ai(turn);
+            long originalNodes = 0;
+            MoveList moves;
+            board.GetLegalMoves(turn, moves);
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (PackedMove move : moves) {
+                board.MakeMove(move);
+                OriginalMinimax(ai, turn, board, SEARCH_DEPTH - 1, -AI::INFINITE_SCORE, AI::INFINITE_SCORE, originalNodes);
+                board.UnmakeMove();
+            }
+
+            std::chrono::duration<double> originalTime = std::chrono::steady_clock::now() - start;
+
+            start = std::chrono::steady_clock::now();
+            ai.GetBestMove(board, SEARCH_DEPTH);
+            std::chrono::duration<double> searchTime = std::chrono::steady_clock::now() - start;
+
+            std::printf("  %-9s original minimax %9ld in %.2f s, iterative PVS %9ld in %.2f s (%.1fx fewer)\n", position.name,
+                        originalNodes, originalTime.count(), ai.GetNodeCount(), searchTime.count(),
+                        double(originalNodes) / ai.GetNodeCount());
+        }
+
+        const int TIME_BUDGET_MS = 200;
+
+        std::printf("Search (%d ms budget, deepest finished iteration)\n", TIME_BUDGET_MS);
+
+        for (const auto& position : POSITIONS) {
+            Board board;
+            PIECE_COLOR turn;
+            board.LoadFen(position.fen, turn);
+
+            AI ai(turn);
+
+            auto start = std::chrono::steady_clock::now();
+            ai.GetBestMove(board, AI::MAX_PLY, TIME_BUDGET_MS);
+            std::chrono::duration<double, std::milli> searchTime = std::chrono::steady_clock::now() - start;
+
+            std::printf("  %-9s depth %2d, score %6d, %9ld nodes in %.0f ms, hashfull %3d, first-move cutoffs %.0f%%\n",
+                        position.name, ai.GetCompletedDepth(), ai.GetScore(), ai.GetNodeCount(), searchTime.count(),
+                        ai.GetHashFull(), ai.GetFirstMoveCutoffRate() * 100);
+        }
+    }
+
+    // What the stress check stores for a key: every field is a function of the key, so a probe
+    // that returns anything else has read a torn entry.
+    struct StressEntry {
+        PackedMove move;
+        int score;
+        int depth;
+        BOUND_TYPE bound;
+    };
+
+    StressEntry StressEntryOf(uint64_t key) {
+        return {
+            PackedMove::FromRaw(uint16_t(key >> 48) | 1),
+            int((key >> 16) % 20001) - 10000,
+            int(key & 63),
+            BOUND_TYPE(B_UPPER + (key >> 8) % 3)
+        };
+    }
+
+    // Many threads storing and probing one small table at once. Keys come from a pool a few
+    // times larger than the table, so threads keep overwriting each other's entries.
+    int CheckTranspositionTableStress() {
+        const int KEY_COUNT = 1 << 18;
+        const long OPERATIONS_PER_THREAD = 2000000;
+
+        int threadCount = std::max(4, int(std::thread::hardware_concurrency()));
+        TranspositionTable table(1);
+
+        std::vector<uint64_t> keys(KEY_COUNT);
+        uint64_t seed = 1;
+
+        for (uint64_t& key : keys) {
+            key = Zobrist::NextRandom(seed);
+        }
+
+        std::atomic<long> hits(0);
+        std::atomic<long> badProbes(0);
+        std::vector<std::thread> threads;
+
+        for (int thread = 0; thread < threadCount; thread++) {
+            threads.emplace_back([&, thread]() {
+                uint64_t threadSeed = 1000 + thread;
+                long threadHits = 0;
+                long threadBadProbes = 0;
+
+                for (long operation = 0; operation < OPERATIONS_PER_THREAD; operation++) {
+                    uint64_t random = Zobrist::NextRandom(threadSeed);
+                    uint64_t key = keys[random % KEY_COUNT];
+                    StressEntry expected = StressEntryOf(key);
+
+                    if (random & (1ULL << 40)) {
+                        table.Store(key, expected.move, expected.score, expected.depth, expected.bound);
+                        continue;
+                    }
+
+                    TTData data;
+
+                    if (!table.Probe(key, data)) {
+                        continue;
+                    }
+
+                    threadHits++;
+                    threadBadProbes += data.move != expected.move || data.score != expected.score ||
+                                       data.depth != expected.depth || data.bound != expected.bound;
+                }
+
+                hits += threadHits;
+                badProbes += threadBadProbes;
+            });
+        }
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        std::printf("Transposition table (%d threads, %ld operations each, %zu KB table)\n", threadCount,
+                    OPERATIONS_PER_THREAD, table.GetSizeInBytes() >> 10);
+        std::printf("  %ld probe hits, %ld invalid: %s\n", hits.load(), badProbes.load(), badProbes == 0 ? "ok" : "FAILED");
+        return badProbes == 0 ? 0 : 1;
+    }
+
+    int CheckGenerators() {
+        struct TestPosition {
+            const char* name;
+            const char* fen;
+            int depth;
+        };
+
+        const TestPosition POSITIONS[] = {
+            {"initial", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4},
+            {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3},
+            {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5},
+            {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4},
+            {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3}
+        };
+
+        std::printf("Generators (captures, quiets and evasions against all legal moves)\n");
+        int failures = 0;
+
+        for (const TestPosition& position : POSITIONS) {
+            Board board;
+            PIECE_COLOR turn;
+
+            if (!board.LoadFen(position.fen, turn)) {
+                std::printf("  %-11s bad FEN\n", position.name);
+                failures++;
+                continue;
+            }
+
+            long nodes = 0;
+            long mismatches = CountGeneratorMismatches(board, turn, position.depth, nodes);
+
+            std::printf("  %-11s %ld nodes, %s\n", position.name, nodes, mismatches == 0 ? "ok" : "MISMATCH");
+            failures += mismatches > 0;
+        }
+
+        return failures;
+    }
+
+    // What the game does when a player promotes: play the move as a queen promotion, then
+    // swap in the chosen piece by square, as the pawn's own piece object is gone by then.
+    // Afterwards the piece lists, the squares and the state must agree, so the moves shown
+    // next can be looked up by piece.
+    int CheckPromotion() {
+        const PIECE_TYPE TYPES[4] = {PIECE_TYPE::QUEEN, PIECE_TYPE::ROOK, PIECE_TYPE::BISHOP, PIECE_TYPE::KNIGHT};
+        const char* EXPECTED_FENS[4] = {
+            "Q3k3/8/8/8/8/8/8/4K3 b - - 0 1",
+            "R3k3/8/8/8/8/8/8/4K3 b - - 0 1",
+            "B3k3/8/8/8/8/8/8/4K3 b - - 0 1",
+            "N3k3/8/8/8/8/8/8/4K3 b - - 0 1"
+        };
+
+        std::printf("Promotion (a7a8 to each piece, then the next side's moves)\n");
+        int failures = 0;
+
+        for (int choice = 0; choice < 4; choice++) {
+            Board board;
+            PIECE_COLOR turn;
+            board.LoadFen("4k3/P7/8/8/8/8/8/4K3 w - - 0 1", turn);
+
+            Position promotionPosition = {0, 0};
+            board.DoMove(board.At(Position{1, 0}), {MOVE_TYPE::PROMOTION, promotionPosition});
+            board.Promote(promotionPosition, TYPES[choice]);
+
+            BoardState expected;
+            expected.LoadFen(EXPECTED_FENS[choice]);
+            bool consistent = board.GetState().key == expected.key;
+
+            for (PIECE_COLOR color : {PIECE_COLOR::C_WHITE, PIECE_COLOR::C_BLACK}) {
+                for (Piece* piece : board.GetPiecesByColor(color)) {
+                    int square = Bitboards::SquareOf(piece->GetPosition());
+                    consistent &= board.At(square) == piece && board.GetState().TypeAt(square) == piece->type;
+                }
+            }
+
+            MoveList moves;
+            board.GetLegalMoves(PIECE_COLOR::C_BLACK, moves);
+
+            for (PackedMove move : moves) {
+                Piece* piece = board.At(move.From());
+                consistent &= piece != nullptr && piece->color == PIECE_COLOR::C_BLACK;
+            }
+
+            std::printf("  %-30s %s\n", board.GetState().GetFen().c_str(), consistent ? "ok" : "MISMATCH");
+            failures += !consistent;
+        }
+
+        return failures;
+    }
+}
+
+int main() {
+    int failures = 0;
+
+    BenchSquareLookup();
+    failures += BenchSliderAttacks();
+    failures += BenchMoveMaking();
+    BenchSearch();
+    failures += CheckGenerators();
+    failures += CheckTranspositionTableStress();
+    failures += CheckPromotion();
+
+    if (failures > 0) {
+        std::printf("\n%d checks failed\n", failures);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
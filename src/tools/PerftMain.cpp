@@ -0,0 +1,400 @@
+// Move generation counter (`make perft`).
+//
+//   perft [options]                   runs the regression suite below and exits non-zero on any mismatch
+//   perft [options] <depth> [fen]     prints the node count below each root move (divide), the total
+//                                     and nodes per second; the FEN defaults to the initial position
+//
+// Options:
+//   -t <threads>    worker threads (default: one per hardware thread). With more than one, divide
+//                   also runs single-threaded and reports per-thread rates and the speedup
+//   -H <megabytes>  perft hash size; subtrees reached again by transposition are counted once
+//                   (default: 0, no hash)
+#include "BoardState.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char* INITIAL_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    struct PerftPosition {
+        const char* name;
+        const char* fen;
+        int depth;
+        uint64_t nodes;
+    };
+
+    // Well-known positions with published counts. The second group is small endgames that each
+    // stress one rule: en passant that would expose the king, castling into or giving check,
+    // promotions (under-promotions included) and stalemate.
+    const PerftPosition SUITE[] = {
+        {"initial", INITIAL_FEN, 6, 119060324},
+        {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690},
+        {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+        {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+        {"position 4 mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292},
+        {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194},
+        {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551},
+
+        {"illegal en passant 1", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888},
+        {"illegal en passant 2", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133},
+        {"en passant check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467},
+        {"short castling check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072},
+        {"long castling check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711},
+        {"castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206},
+        {"castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476},
+        {"promotion out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001},
+        {"discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658},
+        {"promotion check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342},
+        {"under-promotion check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683},
+        {"self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217},
+        {"stalemate and mate 1", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584},
+        {"stalemate and mate 2", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527}
+    };
+
+    // Positions LoadFen has to turn down, as searching them would capture a king.
+    const char* const UNPLAYABLE_FENS[] = {
+        "7k/8/8/8/8/8/r7/1r4K1 b - - 0 1",
+        "8/8/8/8/8/8/8/K7 w - - 0 1",
+        "kk6/8/8/8/8/8/8/K7 w - - 0 1",
+        "P6k/8/8/8/8/8/8/K7 w - - 0 1"
+    };
+
+    // Subtree counts shared by all threads without locks. Each entry is two words, the data
+    // (node count and depth) and the key XORed with the data. A reader only accepts an entry
+    // whose words still XOR to its key, so an entry torn by two threads writing at once reads
+    // as a miss instead of a wrong count.
+    class PerftHash {
+    public:
+        explicit PerftHash(size_t megabytes) {
+            size_t count = 1;
+
+            while (count * 2 * sizeof(Entry) <= megabytes << 20) {
+                count *= 2;
+            }
+
+            entries.reset(new Entry[count]);
+            mask = count - 1;
+            Clear();
+        }
+
+        void Clear() {
+            for (size_t index = 0; index <= mask; index++) {
+                entries[index].check.store(0, std::memory_order_relaxed);
+                entries[index].data.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        bool Probe(uint64_t key, int depth, uint64_t& nodes) const {
+            const Entry& entry = entries[key & mask];
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+            if ((check ^ data) != key || int(data & 255) != depth) {
+                return false;
+            }
+
+            nodes = data >> 8;
+            return true;
+        }
+
+        void Store(uint64_t key, int depth, uint64_t nodes) {
+            Entry& entry = entries[key & mask];
+            uint64_t data = (uint64_t(nodes) << 8) | uint64_t(depth);
+
+            entry.check.store(key ^ data, std::memory_order_relaxed);
+            entry.data.store(data, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+
+        std::unique_ptr<Entry[]> entries;
+        size_t mask;
+    };
+
+    // Leaf count of the legal move tree, playing moves on copies of the state. One ply above
+    // the leaves the legal moves are only counted, not played.
+    uint64_t Perft(const BoardState& state, int depth, PerftHash* hash) {
+        uint64_t key = 0;
+        uint64_t nodes = 0;
+
+        if (hash && depth >= 2) {
+            key = state.key;
+
+            if (hash->Probe(key, depth, nodes)) {
+                return nodes;
+            }
+        }
+
+        MoveList moves;
+        state.GetLegalMoves(state.sideToMove, moves);
+
+        if (depth <= 1) {
+            return depth == 1 ? moves.Size() : 1;
+        }
+
+        for (PackedMove move : moves) {
+            BoardState child = state;
+            child.MakeMove(move);
+
+            nodes += Perft(child, depth - 1, hash);
+        }
+
+        if (hash) {
+            hash->Store(key, depth, nodes);
+        }
+
+        return nodes;
+    }
+
+    struct ThreadStats {
+        uint64_t nodes = 0;
+        double seconds = 0;
+    };
+
+    struct PerftRun {
+        MoveList rootMoves;
+        std::vector<uint64_t> rootNodes;
+        uint64_t nodes = 0;
+        double seconds = 0;
+        std::vector<ThreadStats> threads;
+    };
+
+    // A subtree for a worker: the position some plies below the root, which root move leads
+    // there and how deep to count from it.
+    struct PerftTask {
+        BoardState state;
+        int rootMove;
+        int depth;
+    };
+
+    void SplitTasks(const BoardState& state, int rootMove, int depth, int splitDepth, std::vector<PerftTask>& tasks) {
+        if (splitDepth == 0) {
+            tasks.push_back({state, rootMove, depth});
+            return;
+        }
+
+        MoveList moves;
+        state.GetLegalMoves(state.sideToMove, moves);
+
+        for (PackedMove move : moves) {
+            BoardState child = state;
+            child.MakeMove(move);
+
+            SplitTasks(child, rootMove, depth - 1, splitDepth - 1, tasks);
+        }
+    }
+
+    double SecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Counts the tree on a pool of threads. It is cut two plies below the root (one for shallow
+    // trees), which gives hundreds of subtrees of uneven size, and each thread keeps taking the
+    // next one until none are left.
+    PerftRun RunPerft(const BoardState& state, int depth, int threadCount, PerftHash* hash) {
+        PerftRun run;
+        state.GetLegalMoves(state.sideToMove, run.rootMoves);
+        run.rootNodes.assign(run.rootMoves.Size(), 0);
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<PerftTask> tasks;
+        int splitDepth = depth >= 3 ? 2 : 1;
+
+        for (int rootMove = 0; rootMove < run.rootMoves.Size() && depth >= 1; rootMove++) {
+            BoardState child = state;
+            child.MakeMove(run.rootMoves[rootMove]);
+
+            SplitTasks(child, rootMove, depth - 1, splitDepth - 1, tasks);
+        }
+
+        // Every task's count has its own slot, so workers never write to the same place.
+        std::vector<uint64_t> taskNodes(tasks.size());
+        std::atomic<size_t> nextTask(0);
+        run.threads.resize(threadCount);
+
+        auto work = [&](ThreadStats& stats) {
+            auto threadStart = std::chrono::steady_clock::now();
+
+            for (size_t task = nextTask++; task < tasks.size(); task = nextTask++) {
+                taskNodes[task] = Perft(tasks[task].state, tasks[task].depth, hash);
+                stats.nodes += taskNodes[task];
+            }
+
+            stats.seconds = SecondsSince(threadStart);
+        };
+
+        std::vector<std::thread> workers;
+
+        for (int thread = 1; thread < threadCount; thread++) {
+            workers.emplace_back(work, std::ref(run.threads[thread]));
+        }
+
+        work(run.threads[0]);
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        for (size_t task = 0; task < tasks.size(); task++) {
+            run.rootNodes[tasks[task].rootMove] += taskNodes[task];
+        }
+
+        for (uint64_t nodes : run.rootNodes) {
+            run.nodes += nodes;
+        }
+
+        run.seconds = SecondsSince(start);
+        return run;
+    }
+
+    // Coordinate notation, e.g. e2e4 or e7e8q.
+    std::string MoveName(PackedMove move) {
+        std::string name;
+
+        for (int square : {move.From(), move.To()}) {
+            name += char('a' + square % 8);
+            name += char('1' + square / 8);
+        }
+
+        if (move.IsPromotion()) {
+            name += "prnbqk"[move.PromotionType()];
+        }
+
+        return name;
+    }
+
+    int Divide(const std::string& fen, int depth, int threadCount, PerftHash* hash) {
+        BoardState state;
+
+        if (!state.LoadFen(fen) || depth < 1) {
+            std::fprintf(stderr, "usage: perft [-t threads] [-H megabytes] [<depth> [fen]]\n");
+            return 1;
+        }
+
+        PerftRun run = RunPerft(state, depth, threadCount, hash);
+
+        for (int rootMove = 0; rootMove < run.rootMoves.Size(); rootMove++) {
+            std::printf("%-6s %" PRIu64 "\n", MoveName(run.rootMoves[rootMove]).c_str(), run.rootNodes[rootMove]);
+        }
+
+        std::printf("\n%d moves, %" PRIu64 " nodes in %.3f s (%.0f nodes/s), %d threads\n",
+                    run.rootMoves.Size(), run.nodes, run.seconds, run.nodes / run.seconds, threadCount);
+
+        if (threadCount == 1) {
+            return 0;
+        }
+
+        for (int thread = 0; thread < threadCount; thread++) {
+            const ThreadStats& stats = run.threads[thread];
+            std::printf("  thread %2d: %12" PRIu64 " nodes %14.0f nodes/s\n", thread, stats.nodes, stats.nodes / stats.seconds);
+        }
+
+        // The same count on one thread, from an empty hash, as the baseline.
+        if (hash) {
+            hash->Clear();
+        }
+
+        PerftRun baseline = RunPerft(state, depth, 1, hash);
+
+        std::printf("1 thread: %" PRIu64 " nodes in %.3f s, speedup %.2fx%s\n", baseline.nodes, baseline.seconds,
+                    baseline.seconds / run.seconds, baseline.nodes == run.nodes ? "" : "  MISMATCH");
+        return 0;
+    }
+
+    int RunSuite(int threadCount, PerftHash* hash) {
+        int failures = 0;
+        uint64_t totalNodes = 0;
+        auto suiteStart = std::chrono::steady_clock::now();
+
+        for (const char* fen : UNPLAYABLE_FENS) {
+            BoardState state;
+
+            if (state.LoadFen(fen)) {
+                std::printf("%-24s accepted by LoadFen\n", fen);
+                failures++;
+            }
+        }
+
+        for (const PerftPosition& position : SUITE) {
+            BoardState state;
+
+            if (!state.LoadFen(position.fen)) {
+                std::printf("%-24s bad FEN\n", position.name);
+                failures++;
+                continue;
+            }
+
+            // Writing the position out and reading it back must give the same position.
+            BoardState reloaded;
+
+            if (!reloaded.LoadFen(state.GetFen()) || reloaded.key != state.key) {
+                std::printf("%-24s FEN round trip gives %s\n", position.name, state.GetFen().c_str());
+                failures++;
+            }
+
+            PerftRun run = RunPerft(state, position.depth, threadCount, hash);
+
+            totalNodes += run.nodes;
+            failures += run.nodes != position.nodes;
+
+            std::printf("%-24s perft(%d) = %9" PRIu64 "  %7.3f s %12.0f nodes/s  %s\n", position.name, position.depth,
+                        run.nodes, run.seconds, run.nodes / run.seconds, run.nodes == position.nodes ? "ok" : "MISMATCH");
+        }
+
+        double seconds = SecondsSince(suiteStart);
+
+        std::printf("\n%" PRIu64 " nodes in %.3f s (%.0f nodes/s), %d threads, %d mismatches\n",
+                    totalNodes, seconds, totalNodes / seconds, threadCount, failures);
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    int threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+    size_t hashMegabytes = 0;
+    int arg = 1;
+
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (std::strcmp(argv[arg], "-t") == 0) {
+            threadCount = std::max(1, std::atoi(argv[arg + 1]));
+        } else if (std::strcmp(argv[arg], "-H") == 0) {
+            hashMegabytes = size_t(std::max(0, std::atoi(argv[arg + 1])));
+        } else {
+            break;
+        }
+    }
+
+    std::unique_ptr<PerftHash> hash;
+
+    if (hashMegabytes > 0) {
+        hash.reset(new PerftHash(hashMegabytes));
+    }
+
+    if (arg >= argc) {
+        return RunSuite(threadCount, hash.get());
+    }
+
+    // The FEN may be passed quoted or as separate arguments.
+    std::string fen;
+
+    for (int i = arg + 1; i < argc; i++) {
+        fen += (i > arg + 1 ? " " : "") + std::string(argv[i]);
+    }
+
+    return Divide(fen.empty() ? INITIAL_FEN : fen, std::atoi(argv[arg]), threadCount, hash.get());
+}